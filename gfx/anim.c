@@ -0,0 +1,150 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "anim.h"
+#include "gfx.h"
+
+#include "vga.h"
+
+extern unsigned char vga_data_array[];
+extern int16_t clip_x0;
+extern int16_t clip_y0;
+extern int16_t clip_x1;
+extern int16_t clip_y1;
+
+static inline uint16_t le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static void copyRun(int16_t x, int16_t y, const uint8_t *src, int16_t len)
+{
+	if (y < clip_y0 || y >= clip_y1)
+		return;
+	if (x < clip_x0)
+	{
+		src += clip_x0 - x;
+		len -= clip_x0 - x;
+		x = clip_x0;
+	}
+	if (x + len > clip_x1)
+		len = clip_x1 - x;
+	if (len <= 0)
+		return;
+
+	GFX_copyRows(&vga_data_array[y * LINE_PIXELS + x], LINE_PIXELS, src, len, len, 1);
+}
+
+static void drawRecord(GFXanimPlayer *p, uint32_t offset)
+{
+	const GFXanimation *a = p->anim;
+	const uint8_t *rec = a->data + offset;
+
+	if (*rec++ == ANIM_KEY)
+	{
+		for (uint16_t row = 0; row < a->height; row++, rec += a->width)
+			copyRun(p->x, p->y + row, rec, a->width);
+		return;
+	}
+
+	// Only the changed runs are written, so the cost follows the size of the change
+	uint16_t spans = le16(rec);
+	rec += 2;
+	while (spans--)
+	{
+		uint16_t row = le16(&rec[0]);
+		uint16_t x = le16(&rec[2]);
+		uint16_t len = le16(&rec[4]);
+		copyRun(p->x + x, p->y + row, rec + 6, len);
+		rec += 6 + len;
+	}
+}
+
+void ANIM_init(GFXanimPlayer *p, const GFXanimation *anim, int16_t x, int16_t y, uint8_t ticks, bool loop)
+{
+	p->anim = anim;
+	p->x = x;
+	p->y = y;
+	p->ticks = ticks ? ticks : 1;
+	p->loop = loop;
+	p->playing = false;
+	p->frame = anim->frames;
+	p->last = 0;
+}
+
+void ANIM_play(GFXanimPlayer *p)
+{
+	// Start a step's worth of frames ago, so the next frame is drawn at the next vertical blank
+	p->last = VGA_getFrameCount() - p->ticks;
+	p->playing = true;
+}
+
+void ANIM_stop(GFXanimPlayer *p)
+{
+	p->playing = false;
+}
+
+void ANIM_rewind(GFXanimPlayer *p)
+{
+	// Deltas only apply on top of the previous frame, so start again from the keyframe
+	p->frame = p->anim->frames;
+}
+
+// Finds the record that takes a player to its next frame, false if none is due in the
+// display frame after `now`
+static bool nextFrame(GFXanimPlayer *p, uint32_t now, uint16_t *next, uint32_t *offset)
+{
+	const GFXanimation *a = p->anim;
+	if (!p->playing || now - p->last + 1 < p->ticks)
+		return false;
+
+	if (p->frame >= a->frames)
+	{
+		*next = 0;
+		*offset = a->offsets[0];
+	}
+	else if (p->frame + 1 < a->frames)
+	{
+		*next = p->frame + 1;
+		*offset = a->offsets[*next];
+	}
+	else if (p->loop)
+	{
+		*next = 0;
+		*offset = a->offsets[a->frames];
+	}
+	else
+	{
+		p->playing = false;
+		return false;
+	}
+	return true;
+}
+
+uint8_t ANIM_update(GFXanimPlayer *players, uint8_t n)
+{
+	uint16_t next;
+	uint32_t offset;
+	uint32_t now = VGA_getFrameCount();
+	uint8_t i = 0;
+	while (i < n && !nextFrame(&players[i], now, &next, &offset))
+		i++;
+	if (i == n)
+		return 0;
+
+	// Draw while the beam is in the vertical blank, so no frame shows half of a change.
+	// One wait covers every player, so they all step together in the same blank.
+	VGA_waitForVBlank();
+	uint32_t frame = VGA_getFrameCount();
+	uint8_t drawn = 0;
+	for (; i < n; i++)
+	{
+		GFXanimPlayer *p = &players[i];
+		if (!nextFrame(p, now, &next, &offset))
+			continue;
+		drawRecord(p, offset);
+		p->last = frame;
+		p->frame = next;
+		drawn++;
+	}
+	return drawn;
+}
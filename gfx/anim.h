@@ -0,0 +1,41 @@
+#ifndef _ANIM_H
+#define _ANIM_H
+
+#include "pico/stdlib.h"
+
+// Kinds of frame record
+#define ANIM_KEY 0	 // Every pixel of the frame, row by row
+#define ANIM_DELTA 1 // Only the runs that changed since the previous frame
+
+/// Animation as generated by tools/imgconv -e anim. Each frame record starts with its kind.
+/// Keyframes hold width x height pixel array bytes. Deltas hold a 16-bit span count and then
+/// spans of row, x and length (16 bit each) and that many pixel bytes, all little endian.
+typedef struct
+{
+	uint16_t width;			 ///< Width of the animated area
+	uint16_t height;		 ///< Height of the animated area
+	uint16_t frames;		 ///< Frames in the animation
+	const uint8_t *data;	 ///< Frame records
+	const uint32_t *offsets; ///< Start of each frame record, then of the delta from the last frame back to the first
+} GFXanimation;
+
+/// Plays an animation at a place on the screen
+typedef struct
+{
+	const GFXanimation *anim;
+	int16_t x;
+	int16_t y;
+	uint16_t frame;	 ///< Frame on the screen, `frames` before the first one is drawn
+	uint8_t ticks;	 ///< Display frames each animation frame stays up for
+	bool loop;		 ///< Start over after the last frame
+	bool playing;
+	uint32_t last;	 ///< Display frame the last animation frame was drawn in
+} GFXanimPlayer;
+
+void ANIM_init(GFXanimPlayer *p, const GFXanimation *anim, int16_t x, int16_t y, uint8_t ticks, bool loop);
+void ANIM_play(GFXanimPlayer *p);
+void ANIM_stop(GFXanimPlayer *p);
+void ANIM_rewind(GFXanimPlayer *p);
+uint8_t ANIM_update(GFXanimPlayer *players, uint8_t n);
+
+#endif
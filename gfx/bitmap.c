@@ -0,0 +1,165 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "bitmap.h"
+#include "gfx.h"
+
+#include "vga.h"
+
+#define TILE_SIZE 8
+
+extern unsigned char vga_data_array[];
+extern int16_t clip_x0;
+extern int16_t clip_y0;
+extern int16_t clip_x1;
+extern int16_t clip_y1;
+extern uint8_t gfxTarget;
+
+// A packed row, unpacked into colours with VGA_TRANSPARENT marking undrawn pixels
+static uint8_t bmp_packed[BITMAP_MAX_WIDTH];
+static uint8_t bmp_colors[BITMAP_MAX_WIDTH + TILE_SIZE];
+
+static inline uint16_t rowBytes(uint16_t w, uint8_t bpp)
+{
+	return ((uint32_t)w * bpp + 7) >> 3;
+}
+
+static void unpack(const GFXbitmap *b, const uint8_t *src, uint8_t *out, uint16_t w)
+{
+	switch (b->bpp)
+	{
+	case 1:
+		for (uint16_t i = 0; i < w; i++)
+			out[i] = (src[i >> 3] >> (7 - (i & 7))) & 1 ? b->color : b->background;
+		break;
+	case 3:
+		// Bit stream, most significant bit first, so a pixel can straddle two bytes
+		for (uint16_t i = 0; i < w; i++)
+		{
+			uint32_t bit = i * 3;
+			uint16_t v = src[bit >> 3] << 8;
+			if ((bit & 7) > 5)
+				v |= src[(bit >> 3) + 1];
+			out[i] = (v >> (13 - (bit & 7))) & 7;
+		}
+		break;
+	case 4:
+		// Every value with the VGA_TRANSPARENT bit is transparent on the overlay plane
+		for (uint16_t i = 0; i < w; i++)
+		{
+			uint8_t v = (src[i >> 1] >> ((i & 1) ? 4 : 0)) & 0xf;
+			out[i] = (v & VGA_TRANSPARENT) ? VGA_TRANSPARENT : v;
+		}
+		return;
+	default:
+		for (uint16_t i = 0; i < w; i++)
+			out[i] = src[i] & 7;
+		break;
+	}
+	if (b->transparent >= 0)
+	{
+		for (uint16_t i = 0; i < w; i++)
+			if (out[i] == b->transparent)
+				out[i] = VGA_TRANSPARENT;
+	}
+}
+
+// Expands the next PackBits compressed row, returns the position after it
+static const uint8_t *unpackBits(const uint8_t *src, uint8_t *out, uint16_t len)
+{
+	uint16_t n = 0;
+	while (n < len)
+	{
+		// A run may cross the end of the row, only the part that fits is stored
+		int8_t header = (int8_t)*src++;
+		if (header >= 0)
+		{
+			uint16_t count = header + 1;
+			memcpy(&out[n], src, count < len - n ? count : len - n);
+			src += count;
+			n += count;
+		}
+		else if (header != -128)
+		{
+			uint16_t count = 1 - header;
+			memset(&out[n], *src++, count < len - n ? count : len - n);
+			n += count;
+		}
+	}
+	return src;
+}
+
+// Opaque 8 bpp rows are already pixel array bytes and are copied straight to the screen
+static void copyRaw(const GFXbitmap *b, const uint8_t *src, int16_t x, int16_t y)
+{
+	int16_t x0 = x < clip_x0 ? clip_x0 : x;
+	int16_t y0 = y < clip_y0 ? clip_y0 : y;
+	int16_t x1 = x + b->width > clip_x1 ? clip_x1 : x + b->width;
+	int16_t y1 = y + b->height > clip_y1 ? clip_y1 : y + b->height;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	src += (y0 - y) * b->width + (x0 - x);
+	GFX_copyRows(&vga_data_array[y0 * LINE_PIXELS + x0], LINE_PIXELS, src, b->width, x1 - x0, y1 - y0);
+}
+
+void BITMAP_draw(const GFXbitmap *bmp, uint16_t frame, int16_t x, int16_t y)
+{
+	if (frame >= bmp->frames || bmp->width > BITMAP_MAX_WIDTH)
+		return;
+
+	uint16_t w = bmp->width;
+	uint16_t bytes = rowBytes(w, bmp->bpp);
+	const uint8_t *src = bmp->data;
+
+	// Rows above and below the clip rectangle are never unpacked
+	int16_t first = y < clip_y0 ? clip_y0 - y : 0;
+	int16_t last = y + bmp->height > clip_y1 ? clip_y1 - y : bmp->height;
+
+	switch (bmp->encoding)
+	{
+	case BITMAP_RAW:
+		src += bmp->offsets[frame];
+		if (bmp->bpp == 8 && bmp->transparent < 0 && gfxTarget == GFX_SCREEN)
+		{
+			copyRaw(bmp, src, x, y);
+			return;
+		}
+		for (int16_t row = first; row < last; row++)
+		{
+			unpack(bmp, src + row * bytes, bmp_colors, w);
+			GFX_drawRuns(x, y + row, bmp_colors, w, VGA_TRANSPARENT);
+		}
+		break;
+
+	case BITMAP_RLE:
+		// Rows have to be expanded in order, even those that are clipped
+		src += bmp->offsets[frame];
+		for (int16_t row = 0; row < last; row++)
+		{
+			src = unpackBits(src, bmp_packed, bytes);
+			if (row < first)
+				continue;
+			unpack(bmp, bmp_packed, bmp_colors, w);
+			GFX_drawRuns(x, y + row, bmp_colors, w, VGA_TRANSPARENT);
+		}
+		break;
+
+	case BITMAP_TILES:
+	{
+		uint16_t across = (w + TILE_SIZE - 1) / TILE_SIZE;
+		const uint16_t *map = bmp->map + bmp->offsets[frame];
+		for (int16_t row = first; row < last; row++)
+		{
+			// Each tile row is 8 pixels, so exactly bpp bytes
+			const uint16_t *tiles = &map[(row / TILE_SIZE) * across];
+			for (uint16_t t = 0; t < across; t++)
+			{
+				const uint8_t *p = src + ((uint32_t)tiles[t] * TILE_SIZE + row % TILE_SIZE) * bmp->bpp;
+				unpack(bmp, p, &bmp_colors[t * TILE_SIZE], TILE_SIZE);
+			}
+			GFX_drawRuns(x, y + row, bmp_colors, w, VGA_TRANSPARENT);
+		}
+		break;
+	}
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef _BITMAP_H
+#define _BITMAP_H
+
+#include "pico/stdlib.h"
+
+#ifndef BITMAP_MAX_WIDTH
+#define BITMAP_MAX_WIDTH 320 // Widest frame that can be drawn
+#endif
+
+// How the pixels of each frame are stored
+#define BITMAP_RAW 0   // Packed rows, each padded to a whole byte
+#define BITMAP_RLE 1   // Packed rows, PackBits compressed, runs never cross rows
+#define BITMAP_TILES 2 // 8x8 tiles shared by all frames, with a tile map per frame
+
+/// Image or sprite sheet in one of the native formats, as generated by tools/imgconv.
+/// 1 bpp pixels are `color` where set and `background` where clear, 3 bpp pixels are
+/// colours 0-7, 4 bpp pixels are laid out like the overlay plane (even pixels in the low
+/// nibble, `VGA_TRANSPARENT` is left undrawn) and 8 bpp pixels are pixel array bytes.
+typedef struct
+{
+	uint16_t width;			 ///< Frame width in pixels
+	uint16_t height;		 ///< Frame height in pixels
+	uint16_t frames;		 ///< Frames in a sprite sheet, 1 for a single image
+	uint8_t bpp;			 ///< Bits per pixel: 1, 3, 4 or 8
+	uint8_t encoding;		 ///< BITMAP_RAW, BITMAP_RLE or BITMAP_TILES
+	uint8_t color;			 ///< Colour of set pixels in 1 bpp images
+	uint8_t background;		 ///< Colour of clear pixels in 1 bpp images
+	int8_t transparent;		 ///< Colour that is left undrawn, -1 if the image is opaque
+	const uint8_t *data;	 ///< Pixel rows, compressed rows or tile pixels
+	const uint32_t *offsets; ///< Start of each frame in `data`, or in `map` for tiles
+	const uint16_t *map;	 ///< Tile numbers row by row, tiled images only
+} GFXbitmap;
+
+void BITMAP_draw(const GFXbitmap *bmp, uint16_t frame, int16_t x, int16_t y);
+
+#endif
@@ -0,0 +1,168 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "chart.h"
+#include "gfx.h"
+
+#include "vga.h"
+
+void CHART_init(GFXchart *c, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t channels)
+{
+	memset(c, 0, sizeof(GFXchart));
+	if (w > CHART_MAX_WIDTH)
+		w = CHART_MAX_WIDTH;
+	// The column ring and the row mapping need at least one of each
+	if (w < 1)
+		w = 1;
+	if (h < 1)
+		h = 1;
+	if (channels > CHART_MAX_CHANNELS)
+		channels = CHART_MAX_CHANNELS;
+	c->x = x;
+	c->y = y;
+	c->w = w;
+	c->h = h;
+	c->channels = channels;
+	c->perColumn = 1;
+	c->bg = BLACK;
+	for (uint8_t i = 0; i < CHART_MAX_CHANNELS; i++)
+		c->color[i] = WHITE;
+	CHART_setRange(c, INT16_MIN, INT16_MAX);
+}
+
+void CHART_setRange(GFXchart *c, int16_t vmin, int16_t vmax)
+{
+	if (vmax <= vmin)
+	{
+		// An empty range is made one step wide, ending at the top of int16_t at most
+		if (vmin == INT16_MAX)
+			vmin = INT16_MAX - 1;
+		vmax = vmin + 1;
+	}
+	c->vmin = vmin;
+	c->vmax = vmax;
+	c->scale = (int32_t)(((int64_t)(c->h - 1) << 16) / ((int32_t)vmax - vmin));
+}
+
+void CHART_setColor(GFXchart *c, uint8_t channel, uint16_t color)
+{
+	if (channel < CHART_MAX_CHANNELS)
+		c->color[channel] = color;
+}
+
+void CHART_setBackground(GFXchart *c, uint16_t color)
+{
+	c->bg = color;
+}
+
+void CHART_setDecimation(GFXchart *c, uint32_t samplesPerColumn)
+{
+	c->perColumn = samplesPerColumn ? samplesPerColumn : 1;
+	c->pending = 0;
+}
+
+// Screen row of a sample value, clamped to the plot area. Values are clamped to the range
+// first, so the product stays within (h - 1) << 16.
+static inline int16_t valueToY(GFXchart *c, int16_t v)
+{
+	if (v < c->vmin)
+		v = c->vmin;
+	else if (v > c->vmax)
+		v = c->vmax;
+	int32_t dy = ((int32_t)(v - c->vmin) * c->scale) >> 16;
+	if (dy > c->h - 1)
+		dy = c->h - 1;
+	return c->y + c->h - 1 - dy;
+}
+
+// Draws ring column `idx` at screen column `sx`, joined to the column before it
+static void drawColumn(GFXchart *c, uint16_t idx, int16_t sx, bool first)
+{
+	uint16_t prev = idx ? idx - 1 : c->w;
+
+	GFX_drawFastVLine(sx, c->y, c->h, c->bg);
+	for (uint8_t ch = 0; ch < c->channels; ch++)
+	{
+		int16_t lo = c->ring[idx][ch].min;
+		int16_t hi = c->ring[idx][ch].max;
+		if (!first)
+		{
+			// Stretch the span to meet the previous column so the trace has no gaps
+			if (c->ring[prev][ch].max < lo)
+				lo = c->ring[prev][ch].max;
+			if (c->ring[prev][ch].min > hi)
+				hi = c->ring[prev][ch].min;
+		}
+		int16_t top = valueToY(c, hi);
+		int16_t bottom = valueToY(c, lo);
+		GFX_drawFastVLine(sx, top, bottom - top + 1, c->color[ch]);
+	}
+}
+
+// Draws the newest `n` columns at the right edge of the plot
+static void drawNewest(GFXchart *c, uint16_t n)
+{
+	uint16_t idx = (c->head + c->w + 1 - n + 1) % (c->w + 1);
+	int16_t sx = c->x + c->w - n;
+	for (uint16_t i = 0; i < n; i++)
+	{
+		drawColumn(c, idx, sx + i, c->count == n - i);
+		idx = (idx + 1) % (c->w + 1);
+	}
+}
+
+void CHART_addSamples(GFXchart *c, const int16_t *samples, uint32_t frames)
+{
+	uint16_t added = 0;
+
+	while (frames)
+	{
+		// Take as many frames as the open column still needs, one kernel call per channel
+		uint32_t n = c->perColumn - c->pending;
+		if (n > frames)
+			n = frames;
+
+		for (uint8_t ch = 0; ch < c->channels; ch++)
+		{
+			if (c->pending == 0)
+			{
+				c->open[ch].min = samples[ch];
+				c->open[ch].max = samples[ch];
+			}
+			DEC_accumulate(samples + ch, n, c->channels, &c->open[ch]);
+		}
+		samples += n * c->channels;
+		frames -= n;
+		c->pending += n;
+
+		if (c->pending >= c->perColumn)
+		{
+			c->head = (c->head + 1) % (c->w + 1);
+			memcpy(c->ring[c->head], c->open, sizeof(GFXenvelope) * c->channels);
+			if (c->count <= c->w)
+				c->count++;
+			c->pending = 0;
+			if (added < c->w)
+				added++;
+		}
+	}
+
+	if (!added)
+		return;
+	if (added >= c->w)
+	{
+		CHART_redraw(c);
+		return;
+	}
+
+	// Scroll the existing trace left once, then fill in only the new columns
+	GFX_copyRect(c->x + added, c->y, c->w - added, c->h, c->x, c->y);
+	drawNewest(c, added);
+}
+
+void CHART_redraw(GFXchart *c)
+{
+	uint16_t shown = c->count < c->w ? c->count : c->w;
+
+	GFX_fillRect(c->x, c->y, c->w - shown, c->h, c->bg);
+	drawNewest(c, shown);
+}
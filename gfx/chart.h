@@ -0,0 +1,40 @@
+#ifndef _CHART_H
+#define _CHART_H
+
+#include "pico/stdlib.h"
+#include "decimate.h"
+
+#ifndef CHART_MAX_CHANNELS
+#define CHART_MAX_CHANNELS 4
+#endif
+#ifndef CHART_MAX_WIDTH
+#define CHART_MAX_WIDTH 320
+#endif
+
+/// Scrolling strip chart state
+typedef struct
+{
+	int16_t x, y, w, h;		///< Plot area on screen
+	int16_t vmin, vmax;		///< Sample values mapped to the bottom and top edge
+	int32_t scale;			///< (h - 1) / (vmax - vmin) in 16.16 fixed point
+	uint16_t bg;			///< Background colour of the plot area
+	uint16_t color[CHART_MAX_CHANNELS];
+	uint8_t channels;		///< Interleaved channels per sample frame
+	uint32_t perColumn;		///< Sample frames decimated into one column
+	uint32_t pending;		///< Sample frames accumulated in the open column
+	uint16_t head;			///< Ring index of the newest complete column
+	uint16_t count;			///< Complete columns in the ring, at most w + 1
+	GFXenvelope open[CHART_MAX_CHANNELS];			 ///< Column being accumulated
+	GFXenvelope ring[CHART_MAX_WIDTH + 1][CHART_MAX_CHANNELS]; ///< Decimated history, one column more than shown
+} GFXchart;
+
+void CHART_init(GFXchart *c, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t channels);
+void CHART_setRange(GFXchart *c, int16_t vmin, int16_t vmax);
+void CHART_setColor(GFXchart *c, uint8_t channel, uint16_t color);
+void CHART_setBackground(GFXchart *c, uint16_t color);
+void CHART_setDecimation(GFXchart *c, uint32_t samplesPerColumn);
+
+void CHART_addSamples(GFXchart *c, const int16_t *samples, uint32_t frames);
+void CHART_redraw(GFXchart *c);
+
+#endif
@@ -0,0 +1,161 @@
+#include "pico/stdlib.h"
+#include "decimate.h"
+#include "gfx.h"
+
+#if !PICO_NO_HARDWARE
+#include "pico/multicore.h"
+#endif
+
+// A plain loop over the samples, widening the envelope. It beat ordering pairs read through
+// 32-bit words, and 16-bit bounds leave the compiler free to unroll or vectorise it.
+static void minmaxContiguous(const int16_t *s, uint32_t n, GFXenvelope *env)
+{
+	int16_t lo = env->min;
+	int16_t hi = env->max;
+	for (uint32_t i = 0; i < n; i++)
+	{
+		if (s[i] < lo)
+			lo = s[i];
+		if (s[i] > hi)
+			hi = s[i];
+	}
+	env->min = lo;
+	env->max = hi;
+}
+
+void DEC_accumulate(const int16_t *samples, uint32_t n, uint8_t stride, GFXenvelope *env)
+{
+	if (stride <= 1)
+	{
+		minmaxContiguous(samples, n, env);
+		return;
+	}
+
+	int16_t lo = env->min;
+	int16_t hi = env->max;
+	for (uint32_t i = 0; i < n; i++, samples += stride)
+	{
+		if (*samples < lo)
+			lo = *samples;
+		if (*samples > hi)
+			hi = *samples;
+	}
+	env->min = lo;
+	env->max = hi;
+}
+
+// Decimates the columns [c0, c1) of a `columns` wide envelope
+static void minmaxColumns(const int16_t *samples, uint32_t n, GFXenvelope *out,
+						  uint16_t columns, uint16_t c0, uint16_t c1)
+{
+	uint32_t start = (uint64_t)n * c0 / columns;
+	for (uint16_t c = c0; c < c1; c++)
+	{
+		uint32_t end = (uint64_t)n * (c + 1) / columns;
+		if (end == start)
+		{
+			// Fewer samples than columns
+			out[c].min = out[c].max = samples[start < n ? start : n - 1];
+		}
+		else
+		{
+			out[c].min = out[c].max = samples[start];
+			minmaxContiguous(samples + start + 1, end - start - 1, &out[c]);
+		}
+		start = end;
+	}
+}
+
+void DEC_minmax(const int16_t *samples, uint32_t n, GFXenvelope *out, uint16_t columns)
+{
+	if (!n || !columns)
+		return;
+	minmaxColumns(samples, n, out, columns, 0, columns);
+}
+
+#if !PICO_NO_HARDWARE
+typedef struct
+{
+	const int16_t *samples;
+	uint32_t n;
+	GFXenvelope *out;
+	uint16_t columns;
+	uint16_t c0, c1;
+} DEC_job;
+
+static bool workerRunning = false;
+
+// Runs on core 1, taking job pointers from the inter-core FIFO
+static void decimateWorker(void)
+{
+	while (1)
+	{
+		DEC_job *j = (DEC_job *)(uintptr_t)multicore_fifo_pop_blocking();
+		minmaxColumns(j->samples, j->n, j->out, j->columns, j->c0, j->c1);
+		multicore_fifo_push_blocking(0);
+	}
+}
+
+void DEC_startWorker(void)
+{
+	multicore_launch_core1(decimateWorker);
+	workerRunning = true;
+}
+
+void DEC_minmaxDual(const int16_t *samples, uint32_t n, GFXenvelope *out, uint16_t columns)
+{
+	if (!n || !columns)
+		return;
+	if (!workerRunning || columns < 2)
+	{
+		minmaxColumns(samples, n, out, columns, 0, columns);
+		return;
+	}
+
+	// Core 1 takes the upper half of the columns while this core does the lower half
+	DEC_job job = {samples, n, out, columns, columns / 2, columns};
+	multicore_fifo_push_blocking((uint32_t)(uintptr_t)&job);
+	minmaxColumns(samples, n, out, columns, 0, columns / 2);
+	multicore_fifo_pop_blocking();
+}
+#else
+void DEC_startWorker(void)
+{
+}
+
+void DEC_minmaxDual(const int16_t *samples, uint32_t n, GFXenvelope *out, uint16_t columns)
+{
+	DEC_minmax(samples, n, out, columns);
+}
+#endif
+
+void DEC_draw(int16_t x, int16_t y, int16_t h, const GFXenvelope *env, uint16_t columns,
+			  int16_t vmin, int16_t vmax, uint16_t color)
+{
+	if (vmax <= vmin || h <= 0)
+		return;
+	int32_t scale = (int32_t)(((int64_t)(h - 1) << 16) / ((int32_t)vmax - vmin));
+
+	for (uint16_t c = 0; c < columns; c++)
+	{
+		int32_t lo = env[c].min;
+		int32_t hi = env[c].max;
+		if (c)
+		{
+			// Join each span to its neighbour so steep edges have no gaps
+			if (env[c - 1].max < lo)
+				lo = env[c - 1].max;
+			if (env[c - 1].min > hi)
+				hi = env[c - 1].min;
+		}
+		if (hi < vmin || lo > vmax)
+			continue;
+		if (lo < vmin)
+			lo = vmin;
+		if (hi > vmax)
+			hi = vmax;
+		int16_t top = y + h - 1 - (((hi - vmin) * scale) >> 16);
+		int16_t bottom = y + h - 1 - (((lo - vmin) * scale) >> 16);
+		GFX_drawFastVLine(x + c, top, bottom - top + 1, color);
+	}
+}
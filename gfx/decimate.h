@@ -0,0 +1,22 @@
+#ifndef _DECIMATE_H
+#define _DECIMATE_H
+
+#include "pico/stdlib.h"
+
+/// Min/max of the samples that fall into one pixel column
+typedef struct
+{
+	int16_t min; ///< Smallest sample in the column
+	int16_t max; ///< Largest sample in the column
+} GFXenvelope;
+
+void DEC_accumulate(const int16_t *samples, uint32_t n, uint8_t stride, GFXenvelope *env);
+void DEC_minmax(const int16_t *samples, uint32_t n, GFXenvelope *out, uint16_t columns);
+
+void DEC_startWorker(void);
+void DEC_minmaxDual(const int16_t *samples, uint32_t n, GFXenvelope *out, uint16_t columns);
+
+void DEC_draw(int16_t x, int16_t y, int16_t h, const GFXenvelope *env, uint16_t columns,
+			  int16_t vmin, int16_t vmax, uint16_t color);
+
+#endif
@@ -6,9 +6,14 @@
 #include "gfx.h"
 #include "font.h"
 #include "gfxfont.h"
+#include "gfxmath.h"
 
 #include "vga.h"
 
+#if !PICO_NO_HARDWARE
+#include "hardware/interp.h"
+#endif
+
 #ifndef swap
 #define swap(a, b)     \
 	{                  \
@@ -20,6 +25,7 @@
 
 extern uint16_t _width;	 ///< Display width as modified by current rotation
 extern uint16_t _height; ///< Display height as modified by current rotation
+extern unsigned char vga_data_array[];
 
 int16_t cursor_y = 0;
 int16_t cursor_x = 0;
@@ -32,6 +38,168 @@ uint8_t wrap = 1;
 
 GFXfont *gfxFont = NULL;
 
+// Drawing is limited to this rectangle (right and bottom edges exclusive)
+int16_t clip_x0 = 0;
+int16_t clip_y0 = 0;
+int16_t clip_x1 = LINE_PIXELS;
+int16_t clip_y1 = LINE_COUNT;
+
+// Plane the primitives draw into
+uint8_t gfxTarget = GFX_SCREEN;
+
+void GFX_setTarget(uint8_t t)
+{
+	gfxTarget = t;
+}
+
+// Byte stored in the pixel array for a plain or mixed (GFX_MIX) colour
+static inline uint8_t pixelByte(uint16_t color)
+{
+	return (color & GFX_MIXED) ? color & 0x3f : VGA_PIXEL(color);
+}
+
+// Overlay plane colour, a mix has no room there and shows its first colour
+static inline uint8_t overlayColor(uint16_t color)
+{
+	return (color & GFX_MIXED) ? color & 7 : color & 0xf;
+}
+
+// Writes `w` 4-bit pixels starting at x into a row of the overlay plane
+static void overlaySpan(uint8_t *row, int16_t x, int16_t w, uint16_t color)
+{
+	color = overlayColor(color);
+	if (x & 1)
+	{
+		row[x >> 1] = (row[x >> 1] & 0x0f) | (color << 4);
+		x++;
+		w--;
+	}
+	if (w >= 2)
+	{
+		memset(&row[x >> 1], color | (color << 4), w >> 1);
+		x += w & ~1;
+		w &= 1;
+	}
+	if (w)
+		row[x >> 1] = (row[x >> 1] & 0xf0) | color;
+}
+
+// ===================================== Fill patterns =====================================
+
+// The 8x8 pattern is anchored to the screen, so fills next to each other line up. Each row is
+// kept as the pixel array bytes it writes, two words per row, with a mask of the pixels it
+// covers, so spans are filled a word at a time like solid ones.
+static uint32_t pattern_words[8][2];
+static uint32_t pattern_mask[8][2];
+static uint16_t pattern_colors[8][8]; // For the overlay plane
+static bool pattern_opaque;
+
+static inline bool patternCovers(int16_t x, int16_t y)
+{
+	return (pattern_mask[y & 7][(x >> 2) & 1] >> ((x & 3) * 8)) & 1;
+}
+
+static inline uint8_t patternByte(int16_t x, int16_t y)
+{
+	return pattern_words[y & 7][(x >> 2) & 1] >> ((x & 3) * 8);
+}
+
+// Fills pixels x to x+w-1 of a pixel array row with the pattern
+static void patternSpan(unsigned char *row, int16_t y, int16_t x, int16_t w)
+{
+	const uint32_t *words = pattern_words[y & 7];
+	const uint32_t *mask = pattern_mask[y & 7];
+	int16_t x1 = x + w;
+
+	for (; x < x1 && (x & 3); x++)
+		if (patternCovers(x, y))
+			row[x] = patternByte(x, y);
+	if (pattern_opaque)
+	{
+		for (; x + 4 <= x1; x += 4)
+			*(uint32_t *)&row[x] = words[(x >> 2) & 1];
+	}
+	else
+	{
+		for (; x + 4 <= x1; x += 4)
+		{
+			uint32_t *d = (uint32_t *)&row[x];
+			*d = (*d & ~mask[(x >> 2) & 1]) | words[(x >> 2) & 1];
+		}
+	}
+	for (; x < x1; x++)
+		if (patternCovers(x, y))
+			row[x] = patternByte(x, y);
+}
+
+static void overlayPatternSpan(uint8_t *row, int16_t y, int16_t x, int16_t w)
+{
+	for (; w > 0; w--, x++)
+		if (patternCovers(x, y))
+			overlaySpan(row, x, 1, pattern_colors[y & 7][x & 7]);
+}
+
+// Whether the pattern leaves pixels alone or paints any of colour `old` (as read by fillRead)
+static bool patternKeeps(int16_t old)
+{
+	if (!pattern_opaque)
+		return true;
+	for (uint8_t i = 0; i < 64; i++)
+	{
+		uint16_t c = pattern_colors[i >> 3][i & 7];
+		if ((gfxTarget == GFX_OVERLAY ? overlayColor(c) : pixelByte(c)) == old)
+			return true;
+	}
+	return false;
+}
+
+void GFX_setFillColors(const int16_t *colors)
+{
+	pattern_opaque = true;
+	for (uint8_t y = 0; y < 8; y++)
+	{
+		for (uint8_t x = 0; x < 8; x++)
+		{
+			int16_t c = colors[y * 8 + x];
+			uint32_t shift = (x & 3) * 8;
+			if (x == 0 || x == 4)
+				pattern_words[y][x >> 2] = pattern_mask[y][x >> 2] = 0;
+			pattern_colors[y][x] = c < 0 ? 0 : c;
+			if (c < 0)
+			{
+				pattern_opaque = false;
+				continue;
+			}
+			pattern_words[y][x >> 2] |= (uint32_t)pixelByte(c) << shift;
+			pattern_mask[y][x >> 2] |= 0xffu << shift;
+		}
+	}
+}
+
+void GFX_setFillPattern(const uint8_t *bits, uint16_t fg, int16_t bg)
+{
+	int16_t colors[64];
+	for (uint8_t i = 0; i < 64; i++)
+		colors[i] = (bits[i >> 3] & (0x80 >> (i & 7))) ? fg : bg;
+	GFX_setFillColors(colors);
+}
+
+void GFX_setClipRect(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	clip_x0 = x < 0 ? 0 : x;
+	clip_y0 = y < 0 ? 0 : y;
+	clip_x1 = x + w > _width ? _width : x + w;
+	clip_y1 = y + h > _height ? _height : y + h;
+}
+
+void GFX_resetClipRect()
+{
+	clip_x0 = 0;
+	clip_y0 = 0;
+	clip_x1 = _width;
+	clip_y1 = _height;
+}
+
 void GFX_setClearColor(uint16_t color)
 {
 	clearColour = color;
@@ -49,7 +217,23 @@ void GFX_fillScreen(uint16_t color)
 
 void GFX_drawPixel(int16_t x, int16_t y, uint16_t color)
 {
-	VGA_writePixel(x, y, color);
+	if (x < clip_x0 || y < clip_y0 || x >= clip_x1 || y >= clip_y1)
+		return;
+	if (gfxTarget == GFX_OVERLAY)
+	{
+		uint8_t *row = VGA_getOverlayRow(y);
+		if (!row)
+			return;
+		if (!(color & GFX_PATTERN))
+			overlaySpan(row, x, 1, color);
+		else if (patternCovers(x, y))
+			overlaySpan(row, x, 1, pattern_colors[y & 7][x & 7]);
+		return;
+	}
+	if (!(color & GFX_PATTERN))
+		vga_data_array[y * _width + x] = pixelByte(color);
+	else if (patternCovers(x, y))
+		vga_data_array[y * _width + x] = patternByte(x, y);
 }
 
 void GFX_drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
@@ -105,20 +289,80 @@ void GFX_drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color
 
 void GFX_drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
 {
-	GFX_drawLine(x, y, x, y + h - 1, color);
+	GFX_fillRect(x, y, 1, h, color);
 }
 
 void GFX_drawFastHLine(int16_t x, int16_t y, int16_t l, uint16_t color)
 {
-	GFX_drawLine(x, y, x + l - 1, y, color);
+	GFX_fillRect(x, y, l, 1, color);
+}
+
+void GFX_drawRuns(int16_t x, int16_t y, const uint8_t *pixels, int16_t n, int16_t key)
+{
+	int16_t start = 0;
+	for (int16_t i = 1; i <= n; i++)
+	{
+		if (i == n || pixels[i] != pixels[start])
+		{
+			if (pixels[start] != key)
+				GFX_drawFastHLine(x + start, y, i - start, pixels[start] & 7);
+			start = i;
+		}
+	}
 }
 
 void GFX_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-	for (int16_t i = x; i < x + w; i++)
+	// Clip to the clip rectangle, then fill each row as one span
+	if (x < clip_x0)
 	{
-		GFX_drawFastVLine(i, y, h, color);
+		w -= clip_x0 - x;
+		x = clip_x0;
 	}
+	if (y < clip_y0)
+	{
+		h -= clip_y0 - y;
+		y = clip_y0;
+	}
+	if (x + w > clip_x1)
+		w = clip_x1 - x;
+	if (y + h > clip_y1)
+		h = clip_y1 - y;
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (gfxTarget == GFX_OVERLAY)
+	{
+		for (; h > 0; h--, y++)
+		{
+			uint8_t *row = VGA_getOverlayRow(y);
+			if (!row)
+				continue;
+			if (color & GFX_PATTERN)
+				overlayPatternSpan(row, y, x, w);
+			else
+				overlaySpan(row, x, w, color);
+		}
+		return;
+	}
+
+	if (color & GFX_PATTERN)
+	{
+		for (; h > 0; h--, y++)
+			patternSpan(&vga_data_array[y * _width], y, x, w);
+		return;
+	}
+
+	unsigned char *p = &vga_data_array[y * _width + x];
+	uint8_t c = pixelByte(color);
+	if (w == 1)
+	{
+		for (; h > 0; h--, p += _width)
+			*p = c;
+		return;
+	}
+	for (; h > 0; h--, p += _width)
+		memset(p, c, w);
 }
 
 void GFX_drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
@@ -129,6 +373,262 @@ void GFX_drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 	GFX_drawFastVLine(x + w - 1, y, h, color);
 }
 
+void GFX_copyRect(int16_t src_x, int16_t src_y, int16_t w, int16_t h, int16_t dst_x, int16_t dst_y)
+{
+	// Clip both rectangles to the screen, keeping source and destination aligned
+	if (src_x < 0)
+	{
+		dst_x -= src_x;
+		w += src_x;
+		src_x = 0;
+	}
+	if (src_y < 0)
+	{
+		dst_y -= src_y;
+		h += src_y;
+		src_y = 0;
+	}
+	if (dst_x < 0)
+	{
+		src_x -= dst_x;
+		w += dst_x;
+		dst_x = 0;
+	}
+	if (dst_y < 0)
+	{
+		src_y -= dst_y;
+		h += dst_y;
+		dst_y = 0;
+	}
+	if (src_x + w > _width)
+		w = _width - src_x;
+	if (dst_x + w > _width)
+		w = _width - dst_x;
+	if (src_y + h > _height)
+		h = _height - src_y;
+	if (dst_y + h > _height)
+		h = _height - dst_y;
+	if (w <= 0 || h <= 0 || (src_x == dst_x && src_y == dst_y))
+		return;
+
+	unsigned char *src = &vga_data_array[src_y * _width + src_x];
+	unsigned char *dst = &vga_data_array[dst_y * _width + dst_x];
+	int32_t stride = _width;
+
+	// Moving down, walk the rows bottom-up so none is overwritten before it is read
+	if (dst_y > src_y)
+	{
+		src += (h - 1) * stride;
+		dst += (h - 1) * stride;
+		stride = -stride;
+	}
+
+	// The DMA only copies forwards, which breaks when a row is shifted right onto itself.
+	// Full-width bands moving up go as one contiguous copy.
+	if (dst_y != src_y || dst_x < src_x)
+	{
+		GFX_copyRows(dst, stride, src, stride, w, h);
+		return;
+	}
+	for (int16_t i = 0; i < h; i++, src += stride, dst += stride)
+		memmove(dst, src, w);
+}
+
+void GFX_copyRows(uint8_t *dst, int32_t dst_stride, const uint8_t *src, int32_t src_stride, int16_t w, int16_t h)
+{
+	// Contiguous rows go in a single transfer
+	if (dst_stride == w && src_stride == w)
+	{
+		dma_memcpy(dst, (void *)src, (size_t)w * h);
+		return;
+	}
+	for (; h > 0; h--, dst += dst_stride, src += src_stride)
+	{
+		if (w >= GFX_DMA_MIN_WIDTH)
+			dma_memcpy(dst, (void *)src, w);
+		else
+			memmove(dst, src, w);
+	}
+}
+
+// ===================================== Affine blit =====================================
+
+// Rounds towards minus infinity, whatever the signs
+static inline int64_t floorDiv(int64_t n, int64_t d)
+{
+	int64_t q = n / d;
+	if ((n % d) && ((n < 0) != (d < 0)))
+		q--;
+	return q;
+}
+
+// Narrows [*lo, *hi] to the x where 0 <= start + step * x <= max
+static void affineLimit(int64_t start, int64_t step, int64_t max, int32_t *lo, int32_t *hi)
+{
+	int64_t l, h;
+	if (step == 0)
+	{
+		if (start < 0 || start > max)
+			*hi = *lo - 1;
+		return;
+	}
+	if (step > 0)
+	{
+		l = -floorDiv(start, step);
+		h = floorDiv(max - start, step);
+	}
+	else
+	{
+		l = -floorDiv(max - start, -step);
+		h = floorDiv(start, -step);
+	}
+	if (l > *lo)
+		*lo = l;
+	if (h < *hi)
+		*hi = h;
+}
+
+// Samples `n` source pixels along a span, stepping the 16.16 coordinates
+static void affineSpan(uint8_t *dst, const uint8_t *src, uint16_t stride, uint32_t u, uint32_t v, int32_t du, int32_t dv, int16_t n)
+{
+#if !PICO_NO_HARDWARE
+	// Power of two strides let the interpolator produce each pixel's address in one read:
+	// lane 0 gives the column, lane 1 the row already shifted by the stride, base 2 the image
+	if (!(stride & (stride - 1)))
+	{
+		uint8_t sbits = __builtin_ctz(stride);
+		interp_hw_save_t saved;
+		interp_save(interp0, &saved);
+
+		interp_config c = interp_default_config();
+		interp_config_set_add_raw(&c, true);
+		interp_config_set_shift(&c, 16);
+		interp_config_set_mask(&c, 0, sbits ? sbits - 1 : 0);
+		interp_set_config(interp0, 0, &c);
+		interp_config_set_shift(&c, 16 - sbits);
+		interp_config_set_mask(&c, sbits, 31 - sbits > 15 ? sbits + 15 : 31);
+		interp_set_config(interp0, 1, &c);
+
+		interp0->accum[0] = u;
+		interp0->accum[1] = v;
+		interp0->base[0] = du;
+		interp0->base[1] = dv;
+		interp0->base[2] = (uintptr_t)src;
+
+		// Each pop returns the current address and steps both lanes
+		for (int16_t i = 0; i < n; i++)
+			dst[i] = *(const uint8_t *)(uintptr_t)interp0->pop[2];
+
+		interp_restore(interp0, &saved);
+		return;
+	}
+#endif
+	for (int16_t i = 0; i < n; i++, u += du, v += dv)
+		dst[i] = src[(v >> 16) * stride + (u >> 16)];
+}
+
+void GFX_drawImageAffine(const uint8_t *src, uint16_t w, uint16_t h, uint16_t stride, const GFXaffine *m, int16_t key)
+{
+	static uint8_t row[LINE_PIXELS];
+	const int64_t umax = ((int64_t)w << 16) - 1;
+	const int64_t vmax = ((int64_t)h << 16) - 1;
+
+	for (int16_t y = clip_y0; y < clip_y1; y++)
+	{
+		// Source coordinates of the centre of pixel (0, y), everything else steps from there
+		int64_t u0 = (int64_t)m->b * y + m->c + ((m->a + m->b) >> 1);
+		int64_t v0 = (int64_t)m->e * y + m->f + ((m->d + m->e) >> 1);
+
+		// The part of the row that lands inside the image, solved from the matrix
+		int32_t x0 = clip_x0, x1 = clip_x1 - 1;
+		affineLimit(u0, m->a, umax, &x0, &x1);
+		affineLimit(v0, m->d, vmax, &x0, &x1);
+		if (x0 > x1)
+			continue;
+
+		int16_t n = x1 - x0 + 1;
+		uint32_t u = u0 + (int64_t)m->a * x0;
+		uint32_t v = v0 + (int64_t)m->d * x0;
+		bool direct = gfxTarget == GFX_SCREEN && key < 0;
+		uint8_t *dst = direct ? &vga_data_array[y * LINE_PIXELS + x0] : row;
+		affineSpan(dst, src, stride, u, v, m->a, m->d, n);
+		if (direct)
+			continue;
+
+		GFX_drawRuns(x0, y, row, n, key < 0 ? -1 : VGA_PIXEL(key));
+	}
+}
+
+void GFX_affineRotate(GFXaffine *m, int16_t sx, int16_t sy, int16_t angle, int32_t scale, int16_t x, int16_t y)
+{
+	// Screen to source is the inverse: rotate back by the angle and divide by the scale
+	uint16_t a = MATH_DEG16(angle);
+	int32_t c = ((int64_t)MATH_cos(a) * 65536 + scale / 2) / scale;
+	int32_t s = ((int64_t)MATH_sin(a) * 65536 + scale / 2) / scale;
+	m->a = c;
+	m->b = s;
+	m->d = -s;
+	m->e = c;
+
+	// Screen point x, y lands on source point sx, sy
+	m->c = ((int32_t)sx << 16) - m->a * x - m->b * y;
+	m->f = ((int32_t)sy << 16) - m->d * x - m->e * y;
+}
+
+// ===================================== Scaled blit =====================================
+
+void GFX_drawImageScaled(const uint8_t *src, uint16_t w, uint16_t h, uint16_t stride,
+						 int16_t x, int16_t y, int16_t dw, int16_t dh, int16_t key)
+{
+	static uint16_t cols[LINE_PIXELS];
+	static uint8_t row[LINE_PIXELS];
+	if (!w || !h || dw <= 0 || dh <= 0)
+		return;
+
+	// 16.16 source steps per screen pixel, sampling at pixel centres
+	uint32_t du = ((uint32_t)w << 16) / dw;
+	uint32_t dv = ((uint32_t)h << 16) / dh;
+
+	int16_t x0 = x < clip_x0 ? clip_x0 : x;
+	int16_t x1 = x + dw > clip_x1 ? clip_x1 : x + dw;
+	int16_t y0 = y < clip_y0 ? clip_y0 : y;
+	int16_t y1 = y + dh > clip_y1 ? clip_y1 : y + dh;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	int16_t n = x1 - x0;
+
+	// Every row samples the same columns, so they are worked out once
+	uint32_t u = (du >> 1) + du * (x0 - x);
+	for (int16_t i = 0; i < n; i++, u += du)
+		cols[i] = u >> 16;
+
+	bool direct = gfxTarget == GFX_SCREEN && key < 0;
+	int32_t last = -1;
+	uint32_t v = (dv >> 1) + dv * (y0 - y);
+	for (int16_t yy = y0; yy < y1; yy++, v += dv)
+	{
+		uint32_t sy = v >> 16;
+		uint8_t *dst = direct ? &vga_data_array[yy * LINE_PIXELS + x0] : row;
+
+		// Rows that repeat a source row are copies of the one above
+		if ((int32_t)sy == last)
+		{
+			if (direct)
+				GFX_copyRows(dst, LINE_PIXELS, dst - LINE_PIXELS, LINE_PIXELS, n, 1);
+			else
+				GFX_drawRuns(x0, yy, row, n, key < 0 ? -1 : VGA_PIXEL(key));
+			continue;
+		}
+		last = sy;
+
+		const uint8_t *s = src + sy * stride;
+		for (int16_t i = 0; i < n; i++)
+			dst[i] = s[cols[i]];
+		if (!direct)
+			GFX_drawRuns(x0, yy, row, n, key < 0 ? -1 : VGA_PIXEL(key));
+	}
+}
+
 void GFX_drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color,
 				  uint16_t bg, uint8_t size_x, uint8_t size_y)
 {
@@ -404,6 +904,605 @@ void GFX_drawCircle(int16_t x0, int16_t y0, int16_t r,
 	}
 }
 
+// ===================================== Arcs =====================================
+
+#define ARC_FULL (360 * 16)		 // Arc angles are in 1/16 degree
+#define ARC_MAX_SECTOR (90 * 16) // Arcs are filled in sectors no wider than this
+
+static inline int32_t floorDiv32(int32_t n, int32_t d)
+{
+	int32_t q = n / d;
+	return (n % d && (n < 0) != (d < 0)) ? q - 1 : q;
+}
+
+// Fills the pixels between squared radii rin2 and rout2 (both included) from angle a0 up to a1,
+// no more than 90 degrees apart. Pixels on the a0 edge belong to the sector and those on the a1
+// edge don't, so sectors that meet never overlap or leave gaps.
+static void fillSector(int16_t x0, int16_t y0, int32_t rin2, int32_t rout2, int32_t a0, int32_t a1, uint16_t color)
+{
+	// Edge directions in Q14, small enough that their products with a radius fit 32 bits
+	int32_t ux0 = (MATH_cos(MATH_DEG16(a0)) + 2) >> 2, uy0 = (MATH_sin(MATH_DEG16(a0)) + 2) >> 2;
+	int32_t ux1 = (MATH_cos(MATH_DEG16(a1)) + 2) >> 2, uy1 = (MATH_sin(MATH_DEG16(a1)) + 2) >> 2;
+	int32_t r1 = MATH_isqrt(rout2), r0 = MATH_isqrt(rin2);
+
+	// Rows from the sector's corners, or the edge of the ring where it crosses straight up or down
+	int32_t ys[4] = {uy0 * r0, uy0 * r1, uy1 * r0, uy1 * r1};
+	int32_t top = ys[0], bottom = ys[0];
+	for (uint8_t i = 1; i < 4; i++)
+	{
+		if (ys[i] < top)
+			top = ys[i];
+		if (ys[i] > bottom)
+			bottom = ys[i];
+	}
+	top = floorDiv32(top, 1 << 14);
+	bottom = floorDiv32(bottom, 1 << 14) + 1;
+	int32_t down = ARC_FULL / 4, up = ARC_FULL * 3 / 4;
+	if ((a0 < down && a1 > down) || (a0 < down + ARC_FULL && a1 > down + ARC_FULL))
+		bottom = r1;
+	if ((a0 < up && a1 > up) || (a0 < up + ARC_FULL && a1 > up + ARC_FULL))
+		top = -r1;
+	if (top < -r1)
+		top = -r1;
+	if (bottom > r1)
+		bottom = r1;
+	if (top < clip_y0 - y0)
+		top = clip_y0 - y0;
+	if (bottom >= clip_y1 - y0)
+		bottom = clip_y1 - y0 - 1;
+	if (top > bottom)
+		return;
+
+	// Half widths of the ring on each row, outer rounded down and inner rounded up. Both are
+	// stepped from row to row rather than worked out afresh.
+	int32_t xo = MATH_isqrt(rout2 - top * top);
+	int32_t xi = rin2 > top * top ? MATH_isqrt(rin2 - top * top) : 0;
+	if (xi * xi + top * top < rin2)
+		xi++;
+
+	for (int32_t dy = top; dy <= bottom; dy++)
+	{
+		int32_t dy2 = dy * dy;
+		while ((xo + 1) * (xo + 1) + dy2 <= rout2)
+			xo++;
+		while (xo >= 0 && xo * xo + dy2 > rout2)
+			xo--;
+		while (xi * xi + dy2 < rin2)
+			xi++;
+		while (xi > 0 && (xi - 1) * (xi - 1) + dy2 >= rin2)
+			xi--;
+		if (xo < xi)
+			continue;
+
+		// The edges bound dx from one side each: ux0 * dy - uy0 * dx >= 0 and uy1 * dx - ux1 * dy > 0
+		int32_t lo = -xo, hi = xo;
+		if (uy0 > 0)
+		{
+			int32_t b = floorDiv32(ux0 * dy, uy0);
+			if (b < hi)
+				hi = b;
+		}
+		else if (uy0 < 0)
+		{
+			int32_t b = -floorDiv32(-ux0 * dy, uy0);
+			if (b > lo)
+				lo = b;
+		}
+		else if (ux0 * dy < 0)
+		{
+			continue;
+		}
+		if (uy1 > 0)
+		{
+			int32_t b = floorDiv32(ux1 * dy, uy1) + 1;
+			if (b > lo)
+				lo = b;
+		}
+		else if (uy1 < 0)
+		{
+			int32_t b = -floorDiv32(-ux1 * dy, uy1) - 1;
+			if (b < hi)
+				hi = b;
+		}
+		else if (ux1 * dy >= 0)
+		{
+			continue;
+		}
+
+		// Both sides of the ring's hole
+		if (xi == 0)
+		{
+			if (lo <= hi)
+				GFX_drawFastHLine(x0 + lo, y0 + dy, hi - lo + 1, color);
+			continue;
+		}
+		int32_t l = lo, h = hi < -xi ? hi : -xi;
+		if (l <= h)
+			GFX_drawFastHLine(x0 + l, y0 + dy, h - l + 1, color);
+		l = lo > xi ? lo : xi;
+		h = hi;
+		if (l <= h)
+			GFX_drawFastHLine(x0 + l, y0 + dy, h - l + 1, color);
+	}
+}
+
+// Fills the ring between squared radii from `start` round `sweep`, clockwise from 3 o'clock
+static void fillRing(int16_t x0, int16_t y0, int32_t rin2, int32_t rout2, int16_t start, int16_t sweep, uint16_t color)
+{
+	if (sweep <= 0 || rout2 < rin2)
+		return;
+	if (sweep > ARC_FULL)
+		sweep = ARC_FULL;
+	int32_t a0 = start % ARC_FULL;
+	if (a0 < 0)
+		a0 += ARC_FULL;
+	int32_t a1 = a0 + sweep;
+
+	// The centre is on both edges of every sector, so none of them fill it. It goes with
+	// the arc that covers 3 o'clock, so arcs that meet still share it out exactly.
+	if (!rin2 && (a0 == 0 || a1 > ARC_FULL))
+		GFX_drawPixel(x0, y0, color);
+
+	while (a0 < a1)
+	{
+		int32_t end = a1 - a0 > ARC_MAX_SECTOR ? a0 + ARC_MAX_SECTOR : a1;
+		fillSector(x0, y0, rin2, rout2, a0, end, color);
+		a0 = end;
+	}
+}
+
+void GFX_drawArc(int16_t x0, int16_t y0, int16_t r, int16_t start, int16_t sweep, uint16_t color)
+{
+	GFX_fillArc(x0, y0, r, 1, start, sweep, color);
+}
+
+void GFX_fillArc(int16_t x0, int16_t y0, int16_t r, int16_t thickness, int16_t start, int16_t sweep, uint16_t color)
+{
+	// Pixels further than r - thickness from the centre, and no further than r
+	int32_t inner = r - thickness;
+	fillRing(x0, y0, inner < 0 ? 0 : inner * inner + 1, (int32_t)r * r, start, sweep, color);
+}
+
+void GFX_fillPie(int16_t x0, int16_t y0, int16_t r, int16_t start, int16_t sweep, uint16_t color)
+{
+	fillRing(x0, y0, 0, (int32_t)r * r, start, sweep, color);
+}
+
+// ===================================== Curves and thick lines =====================================
+
+#define SUBPIXEL 16			// Thick outlines are worked out in 1/16 pixel
+#define CURVE_MAX_STEPS 256 // Most segments a curve is split into
+#define MITER_LIMIT 2		// Mitres longer than this many half widths are bevelled
+
+static int16_t curve_points[(CURVE_MAX_STEPS + 1) * 2];
+
+// Segments needed to keep a curve within half a pixel of its chords, from the size of its
+// second differences (Wang's formula): the error shrinks with the square of the steps
+static uint16_t curveSteps(int32_t ddx, int32_t ddy, int32_t scale)
+{
+	uint32_t dd = MATH_isqrt64((int64_t)ddx * ddx + (int64_t)ddy * ddy) * scale;
+	uint16_t n = 1;
+	while (n < CURVE_MAX_STEPS && (uint32_t)n * n * 4 < dd)
+		n <<= 1;
+	return n;
+}
+
+static void drawCurvePoints(uint16_t n, uint8_t thickness, uint16_t color)
+{
+	if (thickness > 1)
+	{
+		GFX_drawPolyline(curve_points, n + 1, thickness, GFX_JOIN_ROUND, color);
+		return;
+	}
+	for (uint16_t i = 0; i < n; i++)
+		GFX_drawLine(curve_points[2 * i], curve_points[2 * i + 1], curve_points[2 * i + 2], curve_points[2 * i + 3], color);
+}
+
+// Rounds a value held at n^k times its size
+static inline int16_t unscale(int64_t v, uint8_t shift)
+{
+	return (v + (1LL << (shift - 1))) >> shift;
+}
+
+void GFX_drawQuadBezier(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+						uint8_t thickness, uint16_t color)
+{
+	// P(t) = a t^2 + b t + c, stepped by forward differences kept at n^2 times their size so they stay exact
+	int32_t ax = x0 - 2 * x1 + x2, ay = y0 - 2 * y1 + y2;
+	int32_t bx = 2 * (x1 - x0), by = 2 * (y1 - y0);
+	uint16_t n = curveSteps(ax, ay, 2);
+	uint8_t k = __builtin_ctz(n);
+
+	int64_t fx = (int64_t)x0 << (2 * k), fy = (int64_t)y0 << (2 * k);
+	int64_t dfx = ax + ((int64_t)bx << k), dfy = ay + ((int64_t)by << k);
+	int64_t ddfx = 2 * ax, ddfy = 2 * ay;
+
+	curve_points[0] = x0;
+	curve_points[1] = y0;
+	for (uint16_t i = 1; i <= n; i++)
+	{
+		fx += dfx;
+		fy += dfy;
+		dfx += ddfx;
+		dfy += ddfy;
+		curve_points[2 * i] = k ? unscale(fx, 2 * k) : fx;
+		curve_points[2 * i + 1] = k ? unscale(fy, 2 * k) : fy;
+	}
+	drawCurvePoints(n, thickness, color);
+}
+
+void GFX_drawCubicBezier(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+						 int16_t x3, int16_t y3, uint8_t thickness, uint16_t color)
+{
+	// P(t) = a t^3 + b t^2 + c t + d, differences kept at n^3 times their size
+	int32_t ax = -x0 + 3 * x1 - 3 * x2 + x3, ay = -y0 + 3 * y1 - 3 * y2 + y3;
+	int32_t bx = 3 * x0 - 6 * x1 + 3 * x2, by = 3 * y0 - 6 * y1 + 3 * y2;
+	int32_t cx = 3 * (x1 - x0), cy = 3 * (y1 - y0);
+
+	// The larger second difference of the control polygon bounds the curvature
+	int32_t ddx0 = x0 - 2 * x1 + x2, ddy0 = y0 - 2 * y1 + y2;
+	int32_t ddx1 = x1 - 2 * x2 + x3, ddy1 = y1 - 2 * y2 + y3;
+	bool first = (int64_t)ddx0 * ddx0 + (int64_t)ddy0 * ddy0 > (int64_t)ddx1 * ddx1 + (int64_t)ddy1 * ddy1;
+	uint16_t n = curveSteps(first ? ddx0 : ddx1, first ? ddy0 : ddy1, 6);
+	uint8_t k = __builtin_ctz(n);
+
+	int64_t fx = (int64_t)x0 << (3 * k), fy = (int64_t)y0 << (3 * k);
+	int64_t dfx = ax + ((int64_t)bx << k) + ((int64_t)cx << (2 * k));
+	int64_t dfy = ay + ((int64_t)by << k) + ((int64_t)cy << (2 * k));
+	int64_t ddfx = 6 * ax + ((int64_t)(2 * bx) << k), ddfy = 6 * ay + ((int64_t)(2 * by) << k);
+	int64_t dddfx = 6 * ax, dddfy = 6 * ay;
+
+	curve_points[0] = x0;
+	curve_points[1] = y0;
+	for (uint16_t i = 1; i <= n; i++)
+	{
+		fx += dfx;
+		fy += dfy;
+		dfx += ddfx;
+		dfy += ddfy;
+		ddfx += dddfx;
+		ddfy += dddfy;
+		curve_points[2 * i] = k ? unscale(fx, 3 * k) : fx;
+		curve_points[2 * i + 1] = k ? unscale(fy, 3 * k) : fy;
+	}
+	drawCurvePoints(n, thickness, color);
+}
+
+// Fills a convex polygon given in 1/16 pixel, covering the pixel centres inside it. Centres on
+// the top and left edges count and those on the bottom and right do not, so shapes that share
+// an edge don't overlap and a line n thick covers n rows.
+static void fillConvex(const int32_t *px, const int32_t *py, uint8_t n, uint16_t color)
+{
+	int32_t top = py[0], bottom = py[0];
+	for (uint8_t i = 1; i < n; i++)
+	{
+		if (py[i] < top)
+			top = py[i];
+		if (py[i] > bottom)
+			bottom = py[i];
+	}
+
+	int32_t y0 = -floorDiv(-(top - SUBPIXEL / 2), SUBPIXEL);
+	int32_t y1 = floorDiv(bottom - SUBPIXEL / 2 - 1, SUBPIXEL);
+	if (y0 < clip_y0)
+		y0 = clip_y0;
+	if (y1 >= clip_y1)
+		y1 = clip_y1 - 1;
+
+	for (int32_t y = y0; y <= y1; y++)
+	{
+		int32_t cy = y * SUBPIXEL + SUBPIXEL / 2;
+		int32_t left = INT32_MAX, right = INT32_MIN;
+		for (uint8_t i = 0; i < n; i++)
+		{
+			uint8_t j = i + 1 == n ? 0 : i + 1;
+			int32_t ya = py[i], yb = py[j];
+			if ((cy < ya && cy < yb) || (cy > ya && cy > yb))
+				continue;
+			int32_t x;
+			if (ya == yb)
+			{
+				// Horizontal edge on the centre line, both ends count
+				x = px[i] < px[j] ? px[i] : px[j];
+				if (x < left)
+					left = x;
+				x = px[i] > px[j] ? px[i] : px[j];
+				if (x > right)
+					right = x;
+				continue;
+			}
+			x = px[i] + (int32_t)(((int64_t)(cy - ya) * (px[j] - px[i])) / (yb - ya));
+			if (x < left)
+				left = x;
+			if (x > right)
+				right = x;
+		}
+		if (left > right)
+			continue;
+		int32_t xl = -floorDiv(-(left - SUBPIXEL / 2), SUBPIXEL);
+		int32_t xr = floorDiv(right - SUBPIXEL / 2 - 1, SUBPIXEL);
+		if (xl <= xr)
+			GFX_drawFastHLine(xl, y, xr - xl + 1, color);
+	}
+}
+
+void GFX_drawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color)
+{
+	int16_t line[4] = {x0, y0, x1, y1};
+	GFX_drawPolyline(line, 2, thickness, GFX_JOIN_MITER, color);
+}
+
+void GFX_drawPolyline(const int16_t *points, uint16_t n, uint8_t thickness, uint8_t join, uint16_t color)
+{
+	if (n < 2)
+		return;
+	if (thickness <= 1)
+	{
+		for (uint16_t i = 0; i + 1 < n; i++)
+			GFX_drawLine(points[2 * i], points[2 * i + 1], points[2 * i + 2], points[2 * i + 3], color);
+		return;
+	}
+
+	// Half the width in 1/16 pixel. Pixel centres are at +8, so point (x,y) sits at x * 16 + 8.
+	int32_t hw = thickness * SUBPIXEL / 2;
+	int32_t prev_nx = 0, prev_ny = 0, prev_dx = 0, prev_dy = 0;
+	bool have_prev = false;
+
+	for (uint16_t i = 0; i + 1 < n; i++)
+	{
+		int32_t ax = points[2 * i] * SUBPIXEL + SUBPIXEL / 2, ay = points[2 * i + 1] * SUBPIXEL + SUBPIXEL / 2;
+		int32_t bx = points[2 * i + 2] * SUBPIXEL + SUBPIXEL / 2, by = points[2 * i + 3] * SUBPIXEL + SUBPIXEL / 2;
+		int32_t dx = bx - ax, dy = by - ay;
+		uint32_t len = MATH_isqrt64((int64_t)dx * dx + (int64_t)dy * dy);
+		if (!len)
+			continue;
+
+		// Normal of the segment, half the width long
+		int32_t nx = (int64_t)-dy * hw / len, ny = (int64_t)dx * hw / len;
+		int32_t qx[4] = {ax + nx, bx + nx, bx - nx, ax - nx};
+		int32_t qy[4] = {ay + ny, by + ny, by - ny, ay - ny};
+		fillConvex(qx, qy, 4, color);
+
+		if (have_prev)
+		{
+			if (join == GFX_JOIN_ROUND)
+			{
+				GFX_fillCircle(points[2 * i], points[2 * i + 1], thickness / 2, color);
+			}
+			else
+			{
+				// The gap opens on the outside of the turn
+				int64_t cross = (int64_t)prev_dx * dy - (int64_t)prev_dy * dx;
+				int32_t s = cross > 0 ? -1 : 1;
+				int32_t s1x = s * prev_nx, s1y = s * prev_ny, s2x = s * nx, s2y = s * ny;
+				int64_t hw2 = (int64_t)hw * hw;
+				int64_t denom = hw2 + (int64_t)s1x * s2x + (int64_t)s1y * s2y;
+
+				// The mitre point is at half width / cos(turn / 2) along the bisector
+				int32_t wx[4] = {ax, ax + s1x, ax, ax + s2x};
+				int32_t wy[4] = {ay, ay + s1y, ay, ay + s2y};
+				if (denom * MITER_LIMIT * MITER_LIMIT > 2 * hw2)
+				{
+					wx[2] = ax + (int32_t)((s1x + s2x) * hw2 / denom);
+					wy[2] = ay + (int32_t)((s1y + s2y) * hw2 / denom);
+					fillConvex(wx, wy, 4, color);
+				}
+				else
+				{
+					// Too sharp, cut the corner off instead
+					wx[2] = wx[3];
+					wy[2] = wy[3];
+					fillConvex(wx, wy, 3, color);
+				}
+			}
+		}
+		prev_nx = nx;
+		prev_ny = ny;
+		prev_dx = dx;
+		prev_dy = dy;
+		have_prev = true;
+	}
+}
+
+// ===================================== Flood fill =====================================
+
+// A span of row y + dy still to be scanned, found from the filled span xl..xr on row y
+typedef struct
+{
+	int16_t y, xl, xr;
+	int8_t dy;
+} GFXfillSpan;
+
+static GFXfillSpan fill_stack[GFX_FILL_STACK];
+static uint16_t fill_top;
+static bool fill_overflow;
+
+// Rows where spans didn't fit on the stack: the columns they covered and which side their
+// filled parent spans were on (1 above, 2 below, 0 for rows with none)
+static int16_t fill_lo[LINE_COUNT];
+static int16_t fill_hi[LINE_COUNT];
+static uint8_t fill_from[LINE_COUNT];
+
+// Pixels this fill has written, one bit each, so the rows above can be scanned again without
+// mistaking pixels that already had the new colour for filled ones. Rows fill_y0 to fill_y1
+// are cleared when the fill ends.
+static uint32_t fill_marks[LINE_COUNT][LINE_PIXELS / 32];
+static int16_t fill_y0, fill_y1;
+
+// Colour of a pixel in the draw target, the whole byte on screen so mixes compare by both
+// colours. -1 where the overlay has no storage.
+static inline int16_t fillRead(int16_t x, int16_t y)
+{
+	if (gfxTarget == GFX_OVERLAY)
+	{
+		uint8_t *row = VGA_getOverlayRow(y);
+		if (!row)
+			return -1;
+		return (x & 1) ? row[x >> 1] >> 4 : row[x >> 1] & 0xf;
+	}
+	return vga_data_array[y * _width + x] & 0x3f;
+}
+
+// Fills pixels l to r of a row and marks them as filled
+static void fillRun(int16_t row, int16_t l, int16_t r, uint16_t color)
+{
+	GFX_drawFastHLine(l, row, r - l + 1, color);
+	if (row < fill_y0)
+		fill_y0 = row;
+	if (row > fill_y1)
+		fill_y1 = row;
+	while (l <= r)
+	{
+		int16_t end = (l | 31) < r ? (l | 31) : r;
+		uint8_t n = end - l + 1;
+		fill_marks[row][l >> 5] |= (n == 32 ? ~0u : (1u << n) - 1) << (l & 31);
+		l = end + 1;
+	}
+}
+
+static inline bool fillMarked(int16_t x, int16_t y)
+{
+	return (fill_marks[y][x >> 5] >> (x & 31)) & 1;
+}
+
+static inline void fillPush(int16_t y, int16_t xl, int16_t xr, int8_t dy)
+{
+	int16_t row = y + dy;
+	if (row < clip_y0 || row >= clip_y1)
+		return;
+	if (fill_top == GFX_FILL_STACK)
+	{
+		// Note where the span was, its row is scanned again once the stack empties
+		if (!fill_from[row])
+		{
+			fill_lo[row] = xl;
+			fill_hi[row] = xr;
+		}
+		else
+		{
+			if (xl < fill_lo[row])
+				fill_lo[row] = xl;
+			if (xr > fill_hi[row])
+				fill_hi[row] = xr;
+		}
+		fill_from[row] |= dy > 0 ? 1 : 2;
+		fill_overflow = true;
+		return;
+	}
+	fill_stack[fill_top++] = (GFXfillSpan){y, xl, xr, dy};
+}
+
+// Fills from the spans on the stack until it is empty
+static void fillSpans(int16_t old, uint16_t color)
+{
+	while (fill_top)
+	{
+		GFXfillSpan s = fill_stack[--fill_top];
+		int16_t row = s.y + s.dy;
+		int16_t x1 = s.xl, x2 = s.xr;
+		int16_t l, r;
+
+		// A run containing x1 may reach left past the parent span, which leaks back the other way
+		if (fillRead(x1, row) == old)
+		{
+			l = x1;
+			while (l > clip_x0 && fillRead(l - 1, row) == old)
+				l--;
+			if (l < x1)
+				fillPush(row, l, x1 - 1, -s.dy);
+			r = x1;
+		}
+		else
+		{
+			r = x1 + 1;
+			while (r <= x2 && fillRead(r, row) != old)
+				r++;
+			l = r;
+		}
+
+		while (r <= x2)
+		{
+			while (r + 1 < clip_x1 && fillRead(r + 1, row) == old)
+				r++;
+			fillRun(row, l, r, color);
+			fillPush(row, l, r, s.dy);
+			if (r > x2)
+				fillPush(row, x2 + 1, r, -s.dy);
+
+			// Step over the boundary to the next run under the parent span
+			r += 2;
+			while (r <= x2 && fillRead(r, row) != old)
+				r++;
+			l = r;
+		}
+	}
+}
+
+bool GFX_floodFill(int16_t x, int16_t y, uint16_t color)
+{
+	if (x < clip_x0 || y < clip_y0 || x >= clip_x1 || y >= clip_y1)
+		return true;
+	int16_t old = fillRead(x, y);
+	if (old < 0)
+		return true;
+	if (color & GFX_PATTERN)
+	{
+		// Pixels of the old colour left behind would be found and filled again without end
+		if (patternKeeps(old))
+			return false;
+	}
+	else if (old == (gfxTarget == GFX_OVERLAY ? overlayColor(color) : pixelByte(color)))
+		return true;
+
+	// Scanline seed fill (Heckbert): each run of the old colour is found and filled as one span,
+	// then the parts of the rows above and below that touch it are queued. Spans are only
+	// queued where the previous row wasn't already scanned, so each pixel is read a few times
+	// at most.
+	fill_top = 0;
+	fill_overflow = false;
+	fill_y0 = LINE_COUNT;
+	fill_y1 = -1;
+	fillPush(y, x, x, 1);
+	fillPush(y + 1, x, x, -1);
+	fillSpans(old, color);
+
+	// Spans that didn't fit were noted by row. Runs of the old colour there that touch pixels
+	// this fill wrote, on the side the spans came from, are filled in turn until none are left.
+	while (fill_overflow)
+	{
+		fill_overflow = false;
+		for (int16_t row = clip_y0; row < clip_y1; row++)
+		{
+			uint8_t from = fill_from[row];
+			if (!from)
+				continue;
+			int16_t xl = fill_lo[row], xr = fill_hi[row];
+			fill_from[row] = 0;
+			for (int16_t i = xl; i <= xr; i++)
+			{
+				if (fillRead(i, row) != old)
+					continue;
+				if (!((from & 1) && fillMarked(i, row - 1)) && !((from & 2) && fillMarked(i, row + 1)))
+					continue;
+
+				int16_t l = i, r = i;
+				while (l > clip_x0 && fillRead(l - 1, row) == old)
+					l--;
+				while (r + 1 < clip_x1 && fillRead(r + 1, row) == old)
+					r++;
+				fillRun(row, l, r, color);
+				fillPush(row, l, r, -1);
+				fillPush(row, l, r, 1);
+				fillSpans(old, color);
+				i = r;
+			}
+		}
+	}
+	if (fill_y1 >= fill_y0)
+		memset(fill_marks[fill_y0], 0, (fill_y1 - fill_y0 + 1) * sizeof(fill_marks[0]));
+	return true;
+}
+
 void GFX_printString(char s[])
 {
 	uint8_t n = strlen(s);
@@ -4,7 +4,52 @@
 #include "pico/stdlib.h"
 #include "gfxfont.h"
 
+#ifndef GFX_DMA_MIN_WIDTH
+#define GFX_DMA_MIN_WIDTH 16 // Rows narrower than this are copied by the CPU, the DMA setup costs more than the copy
+#endif
+#ifndef GFX_FILL_STACK
+#define GFX_FILL_STACK 256 // Row spans GFX_floodFill can have waiting at once
+#endif
+
+// Planes the primitives can draw into
+#define GFX_SCREEN 0  // Pixel array
+#define GFX_OVERLAY 1 // Overlay plane, VGA_TRANSPARENT clears pixels
+
+// Colour alternating between a and b every frame on lines set with VGA_setTemporal, which shows
+// as a mix of the two: half intensities give 27 colours. Elsewhere it shows as the hardware
+// reads the VGA_MIXED byte, and on the overlay plane as a.
+#define GFX_MIXED 0x100
+#define GFX_MIX(a, b) (GFX_MIXED | (a) | ((b) << 3))
+
+// Colour that fills with the pattern set by GFX_setFillPattern or GFX_setFillColors
+#define GFX_PATTERN 0x200
+
+// 8x8 bit patterns for GFX_setFillPattern, one byte per row with the leftmost pixel in the top bit
+#define GFX_CHECKER ((const uint8_t[8]){0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55, 0xaa, 0x55})
+#define GFX_HATCH_UP ((const uint8_t[8]){0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80})
+#define GFX_HATCH_DOWN ((const uint8_t[8]){0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01})
+#define GFX_CROSSHATCH ((const uint8_t[8]){0x81, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x81})
+#define GFX_GRID ((const uint8_t[8]){0xff, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80})
+
+// How thick polylines are joined at their corners
+#define GFX_JOIN_MITER 0 // Sharp corners, bevelled where very sharp
+#define GFX_JOIN_ROUND 1 // Rounded corners
+
+/// Maps screen pixels back to source pixels in 16.16 fixed point: u = a*x + b*y + c, v = d*x + e*y + f
+typedef struct
+{
+	int32_t a, b, c;
+	int32_t d, e, f;
+} GFXaffine;
+
 void GFX_drawPixel(int16_t x, int16_t y, uint16_t color);
+void GFX_setTarget(uint8_t t);
+
+void GFX_setClipRect(int16_t x, int16_t y, int16_t w, int16_t h);
+void GFX_resetClipRect();
+
+void GFX_setFillPattern(const uint8_t *bits, uint16_t fg, int16_t bg);
+void GFX_setFillColors(const int16_t *colors);
 
 void GFX_drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y);
 void GFX_write(uint8_t c);
@@ -16,9 +61,24 @@ void GFX_setFont(const GFXfont *f);
 void GFX_drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
 void GFX_drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
 void GFX_drawFastHLine(int16_t x, int16_t y, int16_t l, uint16_t color);
+void GFX_drawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, uint16_t color);
+void GFX_drawPolyline(const int16_t *points, uint16_t n, uint8_t thickness, uint8_t join, uint16_t color);
+void GFX_drawQuadBezier(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+						uint8_t thickness, uint16_t color);
+void GFX_drawCubicBezier(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+						 int16_t x3, int16_t y3, uint8_t thickness, uint16_t color);
 
 void GFX_drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+bool GFX_floodFill(int16_t x, int16_t y, uint16_t color);
 void GFX_fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void GFX_copyRect(int16_t src_x, int16_t src_y, int16_t w, int16_t h, int16_t dst_x, int16_t dst_y);
+void GFX_copyRows(uint8_t *dst, int32_t dst_stride, const uint8_t *src, int32_t src_stride, int16_t w, int16_t h);
+void GFX_drawRuns(int16_t x, int16_t y, const uint8_t *pixels, int16_t n, int16_t key);
+
+void GFX_drawImageAffine(const uint8_t *src, uint16_t w, uint16_t h, uint16_t stride, const GFXaffine *m, int16_t key);
+void GFX_affineRotate(GFXaffine *m, int16_t sx, int16_t sy, int16_t angle, int32_t scale, int16_t x, int16_t y);
+void GFX_drawImageScaled(const uint8_t *src, uint16_t w, uint16_t h, uint16_t stride,
+						 int16_t x, int16_t y, int16_t dw, int16_t dh, int16_t key);
 
 void GFX_fillScreen(uint16_t color);
 void GFX_setClearColor(uint16_t color);
@@ -26,6 +86,9 @@ void GFX_clearScreen();
 
 void GFX_drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
 void GFX_fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+void GFX_drawArc(int16_t x0, int16_t y0, int16_t r, int16_t start, int16_t sweep, uint16_t color);
+void GFX_fillArc(int16_t x0, int16_t y0, int16_t r, int16_t thickness, int16_t start, int16_t sweep, uint16_t color);
+void GFX_fillPie(int16_t x0, int16_t y0, int16_t r, int16_t start, int16_t sweep, uint16_t color);
 
 void GFX_printf(const char *format, ...);
 void GFX_setTextSize(uint s);
@@ -0,0 +1,210 @@
+#include "pico/stdlib.h"
+#include "gfxmath.h"
+
+#define ATAN_STEPS 20 // CORDIC iterations, each adds about a bit
+
+// First quarter of a sine wave in Q16, 256 steps
+static const int32_t sin_table[257] = {
+	0, 402, 804, 1206, 1608, 2010, 2412, 2814,
+	3216, 3617, 4019, 4420, 4821, 5222, 5623, 6023,
+	6424, 6824, 7224, 7623, 8022, 8421, 8820, 9218,
+	9616, 10014, 10411, 10808, 11204, 11600, 11996, 12391,
+	12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+	15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639,
+	19024, 19409, 19792, 20175, 20557, 20939, 21320, 21699,
+	22078, 22457, 22834, 23210, 23586, 23961, 24335, 24708,
+	25080, 25451, 25821, 26190, 26558, 26925, 27291, 27656,
+	28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+	30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347,
+	33692, 34037, 34380, 34721, 35062, 35401, 35738, 36075,
+	36410, 36744, 37076, 37407, 37736, 38064, 38391, 38716,
+	39040, 39362, 39683, 40002, 40320, 40636, 40951, 41264,
+	41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+	44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056,
+	46341, 46624, 46906, 47186, 47464, 47741, 48015, 48288,
+	48559, 48828, 49095, 49361, 49624, 49886, 50146, 50404,
+	50660, 50914, 51166, 51417, 51665, 51911, 52156, 52398,
+	52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+	54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004,
+	56212, 56418, 56621, 56823, 57022, 57219, 57414, 57607,
+	57798, 57986, 58172, 58356, 58538, 58718, 58896, 59071,
+	59244, 59415, 59583, 59750, 59914, 60075, 60235, 60392,
+	60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+	61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596,
+	62714, 62830, 62943, 63054, 63162, 63268, 63372, 63473,
+	63572, 63668, 63763, 63854, 63944, 64031, 64115, 64197,
+	64277, 64354, 64429, 64501, 64571, 64639, 64704, 64766,
+	64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+	65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436,
+	65457, 65476, 65492, 65505, 65516, 65525, 65531, 65535,
+	65536,
+};
+
+// 2^24 / (256 + i): reciprocals of 1 to 2 in 256 steps, in Q16
+static const uint32_t recip_table[257] = {
+	65536, 65281, 65028, 64777, 64528, 64281, 64035, 63792,
+	63550, 63310, 63072, 62836, 62602, 62369, 62138, 61909,
+	61681, 61455, 61231, 61008, 60787, 60568, 60350, 60133,
+	59919, 59705, 59494, 59283, 59075, 58867, 58662, 58457,
+	58254, 58053, 57852, 57654, 57456, 57260, 57065, 56872,
+	56680, 56489, 56299, 56111, 55924, 55738, 55554, 55370,
+	55188, 55007, 54828, 54649, 54471, 54295, 54120, 53946,
+	53773, 53601, 53431, 53261, 53092, 52925, 52759, 52593,
+	52429, 52265, 52103, 51942, 51782, 51622, 51464, 51306,
+	51150, 50995, 50840, 50686, 50534, 50382, 50231, 50081,
+	49932, 49784, 49637, 49490, 49345, 49200, 49056, 48913,
+	48771, 48630, 48489, 48349, 48210, 48072, 47935, 47798,
+	47663, 47528, 47393, 47260, 47127, 46995, 46864, 46733,
+	46603, 46474, 46346, 46218, 46091, 45965, 45839, 45714,
+	45590, 45467, 45344, 45222, 45100, 44979, 44859, 44739,
+	44620, 44502, 44384, 44267, 44151, 44035, 43919, 43805,
+	43691, 43577, 43464, 43352, 43240, 43129, 43019, 42908,
+	42799, 42690, 42582, 42474, 42367, 42260, 42154, 42048,
+	41943, 41838, 41734, 41631, 41528, 41425, 41323, 41222,
+	41121, 41020, 40920, 40820, 40721, 40623, 40525, 40427,
+	40330, 40233, 40137, 40041, 39946, 39851, 39756, 39662,
+	39569, 39476, 39383, 39291, 39199, 39108, 39017, 38926,
+	38836, 38746, 38657, 38568, 38480, 38392, 38304, 38217,
+	38130, 38044, 37958, 37872, 37787, 37702, 37617, 37533,
+	37449, 37366, 37283, 37200, 37118, 37036, 36954, 36873,
+	36792, 36712, 36631, 36552, 36472, 36393, 36314, 36236,
+	36158, 36080, 36003, 35926, 35849, 35772, 35696, 35620,
+	35545, 35470, 35395, 35320, 35246, 35172, 35099, 35026,
+	34953, 34880, 34808, 34735, 34664, 34592, 34521, 34450,
+	34380, 34309, 34239, 34169, 34100, 34031, 33962, 33893,
+	33825, 33757, 33689, 33622, 33554, 33487, 33421, 33354,
+	33288, 33222, 33157, 33091, 33026, 32961, 32897, 32832,
+	32768,
+};
+
+// atan(2^-i) in 1/2^24 of a turn
+static const uint32_t atan_table[ATAN_STEPS] = {
+	2097152, 1238021, 654136, 332050, 166669,
+	83416, 41718, 20860, 10430, 5215,
+	2608, 1304, 652, 326, 163,
+	81, 41, 20, 10, 5,
+};
+
+int32_t MATH_sin(uint16_t angle)
+{
+	// Fold onto the first quarter, then interpolate between table entries
+	uint16_t a = angle & (MATH_QUARTER - 1);
+	if (angle & MATH_QUARTER)
+		a = MATH_QUARTER - a;
+	uint16_t i = a >> 6, f = a & 63;
+	int32_t v = sin_table[i];
+	if (f)
+		v += ((sin_table[i + 1] - v) * f + 32) >> 6;
+	return (angle & (2 * MATH_QUARTER)) ? -v : v;
+}
+
+int32_t MATH_cos(uint16_t angle)
+{
+	return MATH_sin(angle + MATH_QUARTER);
+}
+
+uint16_t MATH_atan2(int32_t y, int32_t x)
+{
+	if (!x && !y)
+		return 0;
+
+	// CORDIC only converges within about 99 degrees, so start from the right half plane
+	int64_t vx = x, vy = y;
+	uint32_t angle = 0;
+	if (vx < 0)
+	{
+		vx = -vx;
+		vy = -vy;
+		angle = 1u << 23;
+	}
+
+	// Scale to 29 bits for precision, leaving headroom for the 1.65 gain of the rotations
+	uint64_t big = vx | (vy < 0 ? -vy : vy);
+	int8_t shift = 28 - (63 - __builtin_clzll(big));
+	if (shift > 0)
+	{
+		vx *= 1 << shift;
+		vy *= 1 << shift;
+	}
+	else
+	{
+		vx >>= -shift;
+		vy >>= -shift;
+	}
+	int32_t cx = vx, cy = vy;
+
+	// Rotate the vector onto the x axis by +-atan(2^-i), adding up the angle turned
+	for (uint8_t i = 0; i < ATAN_STEPS; i++)
+	{
+		int32_t dx = cx >> i, dy = cy >> i;
+		if (cy > 0)
+		{
+			cx += dy;
+			cy -= dx;
+			angle += atan_table[i];
+		}
+		else
+		{
+			cx -= dy;
+			cy += dx;
+			angle -= atan_table[i];
+		}
+	}
+	return (angle + (1 << 7)) >> 8;
+}
+
+uint16_t MATH_isqrt(uint32_t v)
+{
+	uint32_t r = 0;
+	for (uint32_t bit = 1u << 30; bit; bit >>= 2)
+	{
+		if (v >= r + bit)
+		{
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else
+		{
+			r >>= 1;
+		}
+	}
+	return r;
+}
+
+uint32_t MATH_isqrt64(uint64_t v)
+{
+	if (v <= UINT32_MAX)
+		return MATH_isqrt(v);
+	uint64_t r = 0;
+	for (uint64_t bit = 1ull << 62; bit; bit >>= 2)
+	{
+		if (v >= r + bit)
+		{
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else
+		{
+			r >>= 1;
+		}
+	}
+	return r;
+}
+
+uint32_t MATH_recip(uint32_t d, uint8_t *shift)
+{
+	// There is no reciprocal of zero, and no leading bit to count
+	if (!d)
+	{
+		*shift = 0;
+		return INT32_MAX;
+	}
+
+	// d = 2^k * (1 + (i + f / 65536) / 256), whose reciprocal is interpolated from the table
+	uint8_t k = 31 - __builtin_clz(d);
+	uint32_t n = d << (31 - k);
+	uint32_t i = (n >> 23) & 255, f = (n >> 7) & 0xffff;
+	uint32_t a = recip_table[i], b = recip_table[i + 1];
+	*shift = 16 + k;
+	return a - (((a - b) * f + 32768) >> 16);
+}
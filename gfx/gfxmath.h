@@ -0,0 +1,20 @@
+#ifndef _GFXMATH_H
+#define _GFXMATH_H
+
+#include "pico/stdlib.h"
+
+#define MATH_ONE 65536 // 1.0 in Q16
+
+// Angles are binary, a full turn is 65536 so they wrap around by themselves in a uint16_t
+#define MATH_QUARTER 16384								  // A quarter turn
+#define MATH_DEG(d) ((uint16_t)((int32_t)(d) * 8192 / 45)) // From whole degrees
+#define MATH_DEG16(d) ((uint16_t)((int32_t)(d) * 512 / 45)) // From 1/16 degree
+
+int32_t MATH_sin(uint16_t angle);
+int32_t MATH_cos(uint16_t angle);
+uint16_t MATH_atan2(int32_t y, int32_t x);
+uint16_t MATH_isqrt(uint32_t v);
+uint32_t MATH_isqrt64(uint64_t v);
+uint32_t MATH_recip(uint32_t d, uint8_t *shift);
+
+#endif
@@ -0,0 +1,358 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "imgdec.h"
+#include "gfx.h"
+#include "quantize.h"
+
+#include "vga.h"
+
+// Row scratch shared by the decoders: raw file bytes, RGB pixels and output colours
+static uint8_t img_raw[IMG_MAX_WIDTH * 4];
+static uint8_t img_rgb[IMG_MAX_WIDTH * 3];
+static uint8_t img_colors[IMG_MAX_WIDTH];
+
+static GFXquantizer img_quant;
+static uint8_t img_dither = QUANT_NEAREST;
+
+void IMG_setDither(uint8_t method)
+{
+	img_dither = method;
+}
+
+size_t IMG_readMemory(void *ctx, uint8_t *buf, size_t len)
+{
+	IMGmemory *m = (IMGmemory *)ctx;
+	if (len > m->size - m->pos)
+		len = m->size - m->pos;
+	memcpy(buf, m->data + m->pos, len);
+	m->pos += len;
+	return len;
+}
+
+// ===================================== Row output =====================================
+
+// Reduces a row of RGB to the 8 colours, carrying the error into the next rows
+static void drawRGB(int16_t x, int16_t y, const uint8_t *rgb, uint16_t w)
+{
+	QUANT_row(&img_quant, rgb, img_colors);
+	for (uint16_t i = 0; i < w; i++)
+		img_colors[i] &= 7;
+	GFX_drawRuns(x, y, img_colors, w, -1);
+}
+
+// ===================================== Stream helpers =====================================
+
+static bool readAll(IMGreadFn read, void *ctx, uint8_t *buf, size_t len)
+{
+	while (len)
+	{
+		size_t n = read(ctx, buf, len);
+		if (!n)
+			return false;
+		buf += n;
+		len -= n;
+	}
+	return true;
+}
+
+static bool skip(IMGreadFn read, void *ctx, uint32_t len)
+{
+	while (len)
+	{
+		uint32_t n = len > sizeof(img_raw) ? sizeof(img_raw) : len;
+		if (!readAll(read, ctx, img_raw, n))
+			return false;
+		len -= n;
+	}
+	return true;
+}
+
+static inline uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+// Byte-at-a-time reader over a small buffer, for the formats without fixed row sizes
+typedef struct
+{
+	IMGreadFn read;
+	void *ctx;
+	uint8_t buf[64];
+	uint8_t pos, len;
+	bool eof;
+} IMGbyteReader;
+
+static inline int nextByte(IMGbyteReader *r)
+{
+	if (r->pos == r->len)
+	{
+		if (r->eof)
+			return -1;
+		r->len = r->read(r->ctx, r->buf, sizeof(r->buf));
+		r->pos = 0;
+		if (!r->len)
+		{
+			r->eof = true;
+			return -1;
+		}
+	}
+	return r->buf[r->pos++];
+}
+
+// ===================================== BMP =====================================
+
+#define BMP_FILE_HEADER 14
+#define BMP_INFO_HEADER 40
+
+bool IMG_drawBMP(int16_t x, int16_t y, IMGreadFn read, void *ctx)
+{
+	uint8_t hdr[BMP_FILE_HEADER + BMP_INFO_HEADER];
+	if (!readAll(read, ctx, hdr, sizeof(hdr)) || hdr[0] != 'B' || hdr[1] != 'M')
+		return false;
+
+	uint32_t dataOffset = le32(&hdr[10]);
+	uint32_t infoSize = le32(&hdr[14]);
+	int32_t width = (int32_t)le32(&hdr[18]);
+	int32_t height = (int32_t)le32(&hdr[22]);
+	uint16_t bpp = le16(&hdr[28]);
+	uint32_t compression = le32(&hdr[30]);
+	uint32_t colorsUsed = le32(&hdr[46]);
+
+	if (infoSize < BMP_INFO_HEADER || width <= 0 || height == 0 || compression != 0)
+		return false;
+	if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 24 && bpp != 32)
+		return false;
+
+	// Rows are stored bottom-up unless the height is negative
+	bool topDown = height < 0;
+	if (topDown)
+		height = -height;
+
+	uint32_t pos = sizeof(hdr);
+	if (!skip(read, ctx, infoSize - BMP_INFO_HEADER))
+		return false;
+	pos += infoSize - BMP_INFO_HEADER;
+
+	// Palette entries as RGB, at most 256 for 8 bit images
+	static uint8_t palette[256][3];
+	if (bpp <= 8)
+	{
+		uint32_t entries = colorsUsed ? colorsUsed : (1u << bpp);
+		if (entries > 256)
+			return false;
+		for (uint32_t i = 0; i < entries; i++)
+		{
+			uint8_t bgra[4];
+			if (!readAll(read, ctx, bgra, 4))
+				return false;
+			palette[i][0] = bgra[2];
+			palette[i][1] = bgra[1];
+			palette[i][2] = bgra[0];
+		}
+		pos += entries * 4;
+	}
+	if (dataOffset < pos || !skip(read, ctx, dataOffset - pos))
+		return false;
+
+	uint32_t rowBytes = (((uint32_t)width * bpp + 31) / 32) * 4;
+	uint16_t w = width > IMG_MAX_WIDTH ? IMG_MAX_WIDTH : width;
+	uint32_t keep = rowBytes > sizeof(img_raw) ? sizeof(img_raw) : rowBytes;
+	QUANT_init(&img_quant, w, img_dither);
+
+	for (int32_t row = 0; row < height; row++)
+	{
+		if (!readAll(read, ctx, img_raw, keep) || !skip(read, ctx, rowBytes - keep))
+			return false;
+
+		uint8_t *rgb = img_rgb;
+		for (uint16_t i = 0; i < w; i++, rgb += 3)
+		{
+			const uint8_t *c;
+			switch (bpp)
+			{
+			case 1:
+				c = palette[(img_raw[i >> 3] >> (7 - (i & 7))) & 1];
+				break;
+			case 4:
+				c = palette[(img_raw[i >> 1] >> ((i & 1) ? 0 : 4)) & 0xf];
+				break;
+			case 8:
+				c = palette[img_raw[i]];
+				break;
+			default:
+			{
+				// 24 and 32 bit pixels are stored as BGR(A)
+				const uint8_t *p = &img_raw[i * (bpp / 8)];
+				rgb[0] = p[2];
+				rgb[1] = p[1];
+				rgb[2] = p[0];
+				continue;
+			}
+			}
+			rgb[0] = c[0];
+			rgb[1] = c[1];
+			rgb[2] = c[2];
+		}
+		drawRGB(x, topDown ? y + row : y + height - 1 - row, img_rgb, w);
+	}
+	return true;
+}
+
+// ===================================== QOI =====================================
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+
+bool IMG_drawQOI(int16_t x, int16_t y, IMGreadFn read, void *ctx)
+{
+	uint8_t hdr[14];
+	if (!readAll(read, ctx, hdr, sizeof(hdr)) || memcmp(hdr, "qoif", 4))
+		return false;
+	uint32_t width = be32(&hdr[4]);
+	uint32_t height = be32(&hdr[8]);
+	if (!width || !height)
+		return false;
+
+	static IMGbyteReader r;
+	r.read = read;
+	r.ctx = ctx;
+	r.pos = r.len = 0;
+	r.eof = false;
+
+	uint8_t index[64][4];
+	memset(index, 0, sizeof(index));
+	uint8_t px[4] = {0, 0, 0, 255};
+	uint32_t run = 0;
+	uint16_t w = width > IMG_MAX_WIDTH ? IMG_MAX_WIDTH : width;
+	QUANT_init(&img_quant, w, img_dither);
+
+	for (uint32_t row = 0; row < height; row++)
+	{
+		for (uint32_t i = 0; i < width; i++)
+		{
+			if (run)
+			{
+				run--;
+			}
+			else
+			{
+				int b1 = nextByte(&r);
+				if (b1 < 0)
+					return false;
+				if (b1 == QOI_OP_RGB || b1 == QOI_OP_RGBA)
+				{
+					for (uint8_t c = 0; c < (b1 == QOI_OP_RGB ? 3 : 4); c++)
+					{
+						int v = nextByte(&r);
+						if (v < 0)
+							return false;
+						px[c] = v;
+					}
+				}
+				else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX)
+				{
+					memcpy(px, index[b1], 4);
+				}
+				else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF)
+				{
+					px[0] += ((b1 >> 4) & 3) - 2;
+					px[1] += ((b1 >> 2) & 3) - 2;
+					px[2] += (b1 & 3) - 2;
+				}
+				else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA)
+				{
+					int b2 = nextByte(&r);
+					if (b2 < 0)
+						return false;
+					int vg = (b1 & 0x3f) - 32;
+					px[0] += vg - 8 + ((b2 >> 4) & 0xf);
+					px[1] += vg;
+					px[2] += vg - 8 + (b2 & 0xf);
+				}
+				else
+				{
+					run = b1 & 0x3f;
+				}
+				memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63], px, 4);
+			}
+			if (i < w)
+				memcpy(&img_rgb[i * 3], px, 3);
+		}
+		drawRGB(x, y + row, img_rgb, w);
+	}
+	return true;
+}
+
+// ===================================== PackBits =====================================
+
+// Pixels are one colour (0-7) per byte, compressed as PackBits runs that may cross rows
+bool IMG_drawPackBits(int16_t x, int16_t y, uint16_t w, uint16_t h, IMGreadFn read, void *ctx)
+{
+	static IMGbyteReader r;
+	r.read = read;
+	r.ctx = ctx;
+	r.pos = r.len = 0;
+	r.eof = false;
+
+	uint16_t keep = w > IMG_MAX_WIDTH ? IMG_MAX_WIDTH : w;
+	int16_t literal = 0; // bytes left in a literal run
+	int16_t repeat = 0;	 // copies left of `value`
+	uint8_t value = 0;
+
+	for (uint16_t row = 0; row < h; row++)
+	{
+		for (uint16_t i = 0; i < w; i++)
+		{
+			while (!literal && !repeat)
+			{
+				int n = nextByte(&r);
+				if (n < 0)
+					return false;
+				if (n < 128)
+				{
+					literal = n + 1;
+				}
+				else if (n > 128)
+				{
+					int v = nextByte(&r);
+					if (v < 0)
+						return false;
+					value = v;
+					repeat = 257 - n;
+				}
+				// 128 is a no-op
+			}
+			if (literal)
+			{
+				int v = nextByte(&r);
+				if (v < 0)
+					return false;
+				value = v;
+				literal--;
+			}
+			else
+			{
+				repeat--;
+			}
+			if (i < keep)
+				img_colors[i] = value & 7;
+		}
+		GFX_drawRuns(x, y + row, img_colors, keep, -1);
+	}
+	return true;
+}
@@ -0,0 +1,28 @@
+#ifndef _IMGDEC_H
+#define _IMGDEC_H
+
+#include "pico/stdlib.h"
+
+#ifndef IMG_MAX_WIDTH
+#define IMG_MAX_WIDTH 320 // Widest row kept, pixels past it are decoded and dropped
+#endif
+
+/// Reads up to `len` bytes of the image into `buf`, returns the number read
+typedef size_t (*IMGreadFn)(void *ctx, uint8_t *buf, size_t len);
+
+/// Reader context for an image held in memory (RAM or flash)
+typedef struct
+{
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+} IMGmemory;
+
+size_t IMG_readMemory(void *ctx, uint8_t *buf, size_t len);
+void IMG_setDither(uint8_t method);
+
+bool IMG_drawBMP(int16_t x, int16_t y, IMGreadFn read, void *ctx);
+bool IMG_drawQOI(int16_t x, int16_t y, IMGreadFn read, void *ctx);
+bool IMG_drawPackBits(int16_t x, int16_t y, uint16_t w, uint16_t h, IMGreadFn read, void *ctx);
+
+#endif
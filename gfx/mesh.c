@@ -0,0 +1,408 @@
+#include "pico/stdlib.h"
+#include <stdlib.h>
+#include "string.h"
+#include "mesh.h"
+#include "gfx.h"
+#include "gfxmath.h"
+
+#include "vga.h"
+
+#define SUBPIXEL 16			 // Projected points are kept in 1/16 pixel, pixel centres at +8
+#define SCREEN_LIMIT (1 << 29) // Projected points are held within this, in 1/16 pixel
+#define CAMERA_SHIFT 4		   // Camera space is kept in 1/16 model unit so vertices don't snap
+
+extern unsigned char vga_data_array[];
+extern int16_t clip_x0;
+extern int16_t clip_y0;
+extern int16_t clip_x1;
+extern int16_t clip_y1;
+extern uint8_t gfxTarget;
+
+// Ordered dither thresholds, a pixel is lit when its entry is below the face's shade
+static const uint8_t bayer[4][4] = {
+	{0, 8, 2, 10},
+	{12, 4, 14, 6},
+	{3, 11, 1, 9},
+	{15, 7, 13, 5},
+};
+
+// Vertices in camera space, and on the screen when in front of the near plane
+static int32_t cam_x[MESH_MAX_VERTICES];
+static int32_t cam_y[MESH_MAX_VERTICES];
+static int32_t cam_z[MESH_MAX_VERTICES];
+static int32_t scr_x[MESH_MAX_VERTICES];
+static int32_t scr_y[MESH_MAX_VERTICES];
+static int32_t mesh_near; // Near plane in camera space units
+
+typedef struct
+{
+	int32_t depth; ///< Sum of the vertex distances
+	uint16_t face;
+} GFXfaceDepth;
+
+static GFXfaceDepth mesh_order[MESH_MAX_FACES];
+
+static inline int32_t mulQ16(int32_t a, int32_t b)
+{
+	return ((int64_t)a * b + MATH_ONE / 2) >> 16;
+}
+
+void MESH_initCamera(GFXcamera *cam, int16_t cx, int16_t cy, int32_t focal, int32_t near)
+{
+	cam->cx = cx;
+	cam->cy = cy;
+	cam->focal = focal;
+	cam->near = near < 1 ? 1 : near;
+	cam->ambient = 4;
+	MESH_setLight(cam, -1, 1, -1);
+}
+
+void MESH_setLight(GFXcamera *cam, int32_t x, int32_t y, int32_t z)
+{
+	if (!x && !y && !z)
+		return;
+	// Short vectors are lengthened first so the square root keeps its precision
+	while (abs(x) < (1 << 14) && abs(y) < (1 << 14) && abs(z) < (1 << 14))
+	{
+		x *= 2;
+		y *= 2;
+		z *= 2;
+	}
+	uint32_t len = MATH_isqrt64((int64_t)x * x + (int64_t)y * y + (int64_t)z * z);
+	cam->light[0] = (int64_t)x * MATH_ONE / len;
+	cam->light[1] = (int64_t)y * MATH_ONE / len;
+	cam->light[2] = (int64_t)z * MATH_ONE / len;
+}
+
+void MESH_rotation(GFXtransform *t, uint16_t ax, uint16_t ay, uint16_t az)
+{
+	// Turns about x, then y, then z
+	int32_t sx = MATH_sin(ax), cx = MATH_cos(ax);
+	int32_t sy = MATH_sin(ay), cy = MATH_cos(ay);
+	int32_t sz = MATH_sin(az), cz = MATH_cos(az);
+	int32_t sysx = mulQ16(sy, sx), sycx = mulQ16(sy, cx);
+
+	t->r[0][0] = mulQ16(cz, cy);
+	t->r[0][1] = mulQ16(cz, sysx) - mulQ16(sz, cx);
+	t->r[0][2] = mulQ16(cz, sycx) + mulQ16(sz, sx);
+	t->r[1][0] = mulQ16(sz, cy);
+	t->r[1][1] = mulQ16(sz, sysx) + mulQ16(cz, cx);
+	t->r[1][2] = mulQ16(sz, sycx) - mulQ16(cz, sx);
+	t->r[2][0] = -sy;
+	t->r[2][1] = mulQ16(cy, sx);
+	t->r[2][2] = mulQ16(cy, cx);
+	t->x = t->y = t->z = 0;
+}
+
+void MESH_translate(GFXtransform *t, int32_t x, int32_t y, int32_t z)
+{
+	t->x = x;
+	t->y = y;
+	t->z = z;
+}
+
+// ===================================== Projection =====================================
+
+static inline int32_t clampScreen(int64_t v)
+{
+	return v > SCREEN_LIMIT ? SCREEN_LIMIT : v < -SCREEN_LIMIT ? -SCREEN_LIMIT : v;
+}
+
+static void project(const GFXcamera *cam, int32_t x, int32_t y, int32_t z, int32_t *sx, int32_t *sy)
+{
+	// One reciprocal of the distance serves both coordinates
+	uint8_t shift;
+	int64_t r = (int64_t)MATH_recip(z, &shift) * cam->focal * SUBPIXEL;
+	*sx = cam->cx * SUBPIXEL + SUBPIXEL / 2 + clampScreen((x * r) >> shift);
+	*sy = cam->cy * SUBPIXEL + SUBPIXEL / 2 - clampScreen((y * r) >> shift);
+}
+
+// Screen outline of a face with any part in front of the near plane cut off, returns its points (0, 3 or 4)
+static uint8_t facePolygon(const GFXface *f, const GFXcamera *cam, int32_t *xs, int32_t *ys)
+{
+	uint16_t v[3] = {f->a, f->b, f->c};
+	uint8_t n = 0;
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		uint16_t p = v[i], q = v[i == 2 ? 0 : i + 1];
+		bool pin = cam_z[p] >= mesh_near, qin = cam_z[q] >= mesh_near;
+		if (pin)
+		{
+			xs[n] = scr_x[p];
+			ys[n++] = scr_y[p];
+		}
+		if (pin != qin)
+		{
+			// Where the edge crosses the near plane
+			int32_t dz = cam_z[q] - cam_z[p];
+			int64_t t = mesh_near - cam_z[p];
+			int32_t x = cam_x[p] + (int64_t)(cam_x[q] - cam_x[p]) * t / dz;
+			int32_t y = cam_y[p] + (int64_t)(cam_y[q] - cam_y[p]) * t / dz;
+			project(cam, x, y, mesh_near, &xs[n], &ys[n]);
+			n++;
+		}
+	}
+	return n;
+}
+
+// Twice the signed area on the screen, negative when the points go anticlockwise as seen
+static int64_t polygonArea(const int32_t *xs, const int32_t *ys, uint8_t n)
+{
+	int64_t area = 0;
+	for (uint8_t i = 1; i + 1 < n; i++)
+		area += (int64_t)(xs[i] - xs[0]) * (ys[i + 1] - ys[0]) - (int64_t)(ys[i] - ys[0]) * (xs[i + 1] - xs[0]);
+	return area;
+}
+
+// Shade from 0 to 16 for the light falling on a face
+static uint8_t faceShade(const GFXface *f, const GFXcamera *cam)
+{
+	int32_t ux = cam_x[f->b] - cam_x[f->a], uy = cam_y[f->b] - cam_y[f->a], uz = cam_z[f->b] - cam_z[f->a];
+	int32_t wx = cam_x[f->c] - cam_x[f->a], wy = cam_y[f->c] - cam_y[f->a], wz = cam_z[f->c] - cam_z[f->a];
+
+	// Outward normal, (c - a) x (b - a) as camera space is left handed, scaled down so its
+	// squares and its product with the light fit 32 bits
+	int64_t nx = (int64_t)wy * uz - (int64_t)wz * uy;
+	int64_t ny = (int64_t)wz * ux - (int64_t)wx * uz;
+	int64_t nz = (int64_t)wx * uy - (int64_t)wy * ux;
+	uint64_t big = llabs(nx) | llabs(ny) | llabs(nz);
+	if (big >= (1 << 14))
+	{
+		uint8_t shift = 64 - __builtin_clzll(big) - 14;
+		nx >>= shift;
+		ny >>= shift;
+		nz >>= shift;
+	}
+	uint32_t len = MATH_isqrt(nx * nx + ny * ny + nz * nz);
+	int32_t dot = (int32_t)nx * cam->light[0] + (int32_t)ny * cam->light[1] + (int32_t)nz * cam->light[2];
+	if (!len || dot <= 0)
+		return cam->ambient;
+	return cam->ambient + (((16 - cam->ambient) * (dot / (int32_t)len) + MATH_ONE / 2) >> 16);
+}
+
+// ===================================== Rasterizing =====================================
+
+static inline int32_t ceil16(int32_t v)
+{
+	return -((-v) >> 4);
+}
+
+// Fills pixels x0 to x1 - 1 of a row with the face colour dithered down to `shade`
+static void ditherSpan(int16_t y, int16_t x0, int16_t x1, uint8_t color, uint8_t shade)
+{
+	uint8_t pattern[4];
+	for (uint8_t i = 0; i < 4; i++)
+		pattern[i] = bayer[y & 3][i] < shade ? color : BLACK;
+
+	if (gfxTarget == GFX_OVERLAY)
+	{
+		for (int16_t x = x0; x < x1; x++)
+			GFX_drawPixel(x, y, pattern[x & 3]);
+		return;
+	}
+
+	uint8_t *p = &vga_data_array[y * LINE_PIXELS];
+	if (shade == 0 || shade >= 16)
+	{
+		memset(&p[x0], VGA_PIXEL(pattern[0]), x1 - x0);
+		return;
+	}
+	// Whole words of the 4 pixel pattern once aligned
+	for (; x0 < x1 && (x0 & 3); x0++)
+		p[x0] = VGA_PIXEL(pattern[x0 & 3]);
+	uint32_t word = VGA_PIXEL(pattern[0]) | (VGA_PIXEL(pattern[1]) << 8) |
+					(VGA_PIXEL(pattern[2]) << 16) | ((uint32_t)VGA_PIXEL(pattern[3]) << 24);
+	for (; x0 + 4 <= x1; x0 += 4)
+		*(uint32_t *)&p[x0] = word;
+	for (; x0 < x1; x0++)
+		p[x0] = VGA_PIXEL(pattern[x0 & 3]);
+}
+
+// X of an edge at height y in 16.16 of 1/16 pixels, and its change per pixel row
+static inline int64_t edgeStart(int32_t xa, int32_t ya, int32_t xb, int32_t yb, int32_t y, int64_t *step)
+{
+	uint8_t shift;
+	uint32_t r = MATH_recip(yb - ya, &shift);
+	int64_t slope = ((int64_t)(xb - xa) * 65536 * r) >> shift;
+	*step = slope * SUBPIXEL;
+	return (int64_t)xa * 65536 + slope * (y - ya);
+}
+
+static void fillSpans(int32_t row, int32_t end, int64_t xa, int64_t sa, int64_t xb, int64_t sb, uint8_t color, uint8_t shade)
+{
+	for (; row < end; row++, xa += sa, xb += sb)
+	{
+		int64_t l = xa < xb ? xa : xb, r = xa < xb ? xb : xa;
+		// Pixels whose centres are on or right of the left edge and left of the right edge
+		const int64_t centre = (int64_t)(SUBPIXEL / 2) << 16;
+		int64_t x0 = -((centre - l) >> 20), x1 = -((centre - r) >> 20);
+		if (x0 < clip_x0)
+			x0 = clip_x0;
+		if (x1 > clip_x1)
+			x1 = clip_x1;
+		if (x0 < x1)
+			ditherSpan(row, x0, x1, color, shade);
+	}
+}
+
+static inline void swapPoints(int32_t *xa, int32_t *ya, int32_t *xb, int32_t *yb)
+{
+	int32_t t = *xa;
+	*xa = *xb;
+	*xb = t;
+	t = *ya;
+	*ya = *yb;
+	*yb = t;
+}
+
+// Fills the pixels whose centres are inside a triangle given in 1/16 pixel, top and left edges included
+static void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint8_t color, uint8_t shade)
+{
+	if (y0 > y1)
+		swapPoints(&x0, &y0, &x1, &y1);
+	if (y1 > y2)
+		swapPoints(&x1, &y1, &x2, &y2);
+	if (y0 > y1)
+		swapPoints(&x0, &y0, &x1, &y1);
+	if (y0 == y2)
+		return;
+
+	// Rows whose centres lie in [y0, y2), split where the short side turns at y1
+	int32_t r0 = ceil16(y0 - SUBPIXEL / 2), r1 = ceil16(y2 - SUBPIXEL / 2), rm = ceil16(y1 - SUBPIXEL / 2);
+	if (r0 < clip_y0)
+		r0 = clip_y0;
+	if (r1 > clip_y1)
+		r1 = clip_y1;
+	if (r0 >= r1)
+		return;
+	rm = rm < r0 ? r0 : rm > r1 ? r1 : rm;
+
+	int64_t sl, ss;
+	int64_t xl = edgeStart(x0, y0, x2, y2, r0 * SUBPIXEL + SUBPIXEL / 2, &sl);
+	if (r0 < rm)
+	{
+		int64_t xs = edgeStart(x0, y0, x1, y1, r0 * SUBPIXEL + SUBPIXEL / 2, &ss);
+		fillSpans(r0, rm, xl, sl, xs, ss, color, shade);
+		xl += sl * (rm - r0);
+	}
+	if (rm < r1)
+	{
+		int64_t xs = edgeStart(x1, y1, x2, y2, rm * SUBPIXEL + SUBPIXEL / 2, &ss);
+		fillSpans(rm, r1, xl, sl, xs, ss, color, shade);
+	}
+}
+
+static uint8_t outcode(int32_t x, int32_t y, const int32_t *box)
+{
+	return (x < box[0]) | ((x > box[2]) << 1) | ((y < box[1]) << 2) | ((y > box[3]) << 3);
+}
+
+// Draws an edge given in 1/16 pixel, cut down first to just outside the clip rectangle so far
+// off points neither wrap around nor take long to step through
+static void drawEdge(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint8_t color)
+{
+	const int32_t box[4] = {(clip_x0 - 1) * SUBPIXEL, (clip_y0 - 1) * SUBPIXEL, (clip_x1 + 1) * SUBPIXEL, (clip_y1 + 1) * SUBPIXEL};
+	uint8_t c0 = outcode(x0, y0, box), c1 = outcode(x1, y1, box);
+	while (c0 | c1)
+	{
+		if (c0 & c1)
+			return;
+		uint8_t c = c0 ? c0 : c1;
+		int32_t x, y;
+		if (c & 1)
+		{
+			x = box[0];
+			y = y0 + (int64_t)(y1 - y0) * (x - x0) / (x1 - x0);
+		}
+		else if (c & 2)
+		{
+			x = box[2];
+			y = y0 + (int64_t)(y1 - y0) * (x - x0) / (x1 - x0);
+		}
+		else if (c & 4)
+		{
+			y = box[1];
+			x = x0 + (int64_t)(x1 - x0) * (y - y0) / (y1 - y0);
+		}
+		else
+		{
+			y = box[3];
+			x = x0 + (int64_t)(x1 - x0) * (y - y0) / (y1 - y0);
+		}
+		if (c == c0)
+		{
+			x0 = x;
+			y0 = y;
+			c0 = outcode(x0, y0, box);
+		}
+		else
+		{
+			x1 = x;
+			y1 = y;
+			c1 = outcode(x1, y1, box);
+		}
+	}
+	GFX_drawLine(x0 >> 4, y0 >> 4, x1 >> 4, y1 >> 4, color);
+}
+
+// ===================================== Drawing =====================================
+
+static int compareDepth(const void *a, const void *b)
+{
+	int32_t da = ((const GFXfaceDepth *)a)->depth, db = ((const GFXfaceDepth *)b)->depth;
+	return da < db ? 1 : da > db ? -1 : 0;
+}
+
+uint16_t MESH_draw(const GFXmesh *mesh, const GFXtransform *t, const GFXcamera *cam, uint8_t mode)
+{
+	if (mesh->vertices > MESH_MAX_VERTICES)
+		return 0;
+
+	// Into camera space, and onto the screen where in front of the near plane
+	const uint8_t shift = 16 - CAMERA_SHIFT;
+	mesh_near = cam->near << CAMERA_SHIFT;
+	for (uint16_t i = 0; i < mesh->vertices; i++)
+	{
+		const GFXvertex *v = &mesh->vertex[i];
+		cam_x[i] = ((t->r[0][0] * v->x + t->r[0][1] * v->y + t->r[0][2] * v->z + (1 << (shift - 1))) >> shift) + t->x * (1 << CAMERA_SHIFT);
+		cam_y[i] = ((t->r[1][0] * v->x + t->r[1][1] * v->y + t->r[1][2] * v->z + (1 << (shift - 1))) >> shift) + t->y * (1 << CAMERA_SHIFT);
+		cam_z[i] = ((t->r[2][0] * v->x + t->r[2][1] * v->y + t->r[2][2] * v->z + (1 << (shift - 1))) >> shift) + t->z * (1 << CAMERA_SHIFT);
+		if (cam_z[i] >= mesh_near)
+			project(cam, cam_x[i], cam_y[i], cam_z[i], &scr_x[i], &scr_y[i]);
+	}
+
+	// Keep the faces that face the camera and aren't wholly behind it, furthest first
+	uint16_t count = 0;
+	int32_t xs[4], ys[4];
+	for (uint16_t i = 0; i < mesh->faces && count < MESH_MAX_FACES; i++)
+	{
+		const GFXface *f = &mesh->face[i];
+		uint8_t n = facePolygon(f, cam, xs, ys);
+		if (n < 3)
+			continue;
+		if (!(mode & MESH_BACKFACES) && polygonArea(xs, ys, n) >= 0)
+			continue;
+		mesh_order[count].depth = cam_z[f->a] + cam_z[f->b] + cam_z[f->c];
+		mesh_order[count++].face = i;
+	}
+	qsort(mesh_order, count, sizeof(GFXfaceDepth), compareDepth);
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		const GFXface *f = &mesh->face[mesh_order[i].face];
+		uint8_t n = facePolygon(f, cam, xs, ys);
+		if (mode & MESH_SHADED)
+		{
+			uint8_t shade = faceShade(f, cam);
+			fillTriangle(xs[0], ys[0], xs[1], ys[1], xs[2], ys[2], f->color, shade);
+			if (n == 4)
+				fillTriangle(xs[0], ys[0], xs[2], ys[2], xs[3], ys[3], f->color, shade);
+		}
+		if (mode & MESH_WIREFRAME)
+		{
+			for (uint8_t j = 0; j < n; j++)
+				drawEdge(xs[j], ys[j], xs[j + 1 == n ? 0 : j + 1], ys[j + 1 == n ? 0 : j + 1], f->color);
+		}
+	}
+	return count;
+}
@@ -0,0 +1,63 @@
+#ifndef _MESH_H
+#define _MESH_H
+
+#include "pico/stdlib.h"
+
+#ifndef MESH_MAX_VERTICES
+#define MESH_MAX_VERTICES 256 // Most vertices a mesh can have
+#endif
+#ifndef MESH_MAX_FACES
+#define MESH_MAX_FACES 512 // Most faces that can be drawn at once after culling
+#endif
+
+// What MESH_draw draws, combine with |
+#define MESH_SHADED 1	 // Faces filled with their colour, dithered by the light falling on them
+#define MESH_WIREFRAME 2 // Face edges in the face colour
+#define MESH_BACKFACES 4 // Keep faces turned away from the camera, for see-through wireframes
+
+/// Point of a mesh in model units, which must stay within +-8191
+typedef struct
+{
+	int16_t x, y, z;
+} GFXvertex;
+
+/// Triangle of a mesh. Vertices go anticlockwise when the face is seen from outside.
+typedef struct
+{
+	uint16_t a, b, c; ///< Vertex indices
+	uint8_t color;	  ///< Colour when fully lit
+} GFXface;
+
+typedef struct
+{
+	uint16_t vertices;
+	uint16_t faces;
+	const GFXvertex *vertex;
+	const GFXface *face;
+} GFXmesh;
+
+/// Places a mesh in front of the camera: rotation in Q16, then a move in model units. Angles
+/// are binary, see gfxmath.h.
+typedef struct
+{
+	int32_t r[3][3];
+	int32_t x, y, z;
+} GFXtransform;
+
+/// Camera space has x to the right, y up and z into the screen, with the eye at the origin
+typedef struct
+{
+	int16_t cx, cy;	 ///< Screen position of the centre of view
+	int32_t focal;	 ///< Pixels covered by one model unit at a distance of one unit
+	int32_t near;	 ///< Parts of faces closer than this are cut off
+	int32_t light[3]; ///< Unit vector towards the light in Q16
+	uint8_t ambient; ///< Shade of faces turned away from the light, 0 (black) to 16 (full colour)
+} GFXcamera;
+
+void MESH_initCamera(GFXcamera *cam, int16_t cx, int16_t cy, int32_t focal, int32_t near);
+void MESH_setLight(GFXcamera *cam, int32_t x, int32_t y, int32_t z);
+void MESH_rotation(GFXtransform *t, uint16_t ax, uint16_t ay, uint16_t az);
+void MESH_translate(GFXtransform *t, int32_t x, int32_t y, int32_t z);
+uint16_t MESH_draw(const GFXmesh *mesh, const GFXtransform *t, const GFXcamera *cam, uint8_t mode);
+
+#endif
@@ -0,0 +1,94 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "quantize.h"
+
+#include "vga.h"
+
+#define PAD 2
+
+static const uint8_t channel_bits[3] = {RED, GREEN, BLUE};
+
+void QUANT_init(GFXquantizer *q, uint16_t width, uint8_t method)
+{
+	q->method = method;
+	q->width = width > QUANT_MAX_WIDTH ? QUANT_MAX_WIDTH : width;
+	q->row = 0;
+	memset(q->err, 0, sizeof(q->err));
+	memset(q->err_after, 0, sizeof(q->err_after));
+}
+
+// Diffuses one channel of a row, setting that channel's bit in `out`. A single error row
+// serves this row and the next: pixels already done hold the error for the next row, the
+// ones still to come hold their own. What goes ahead in this row and to the slot below
+// ahead is carried in variables until the pixel there is read.
+static void diffuse(GFXquantizer *q, uint8_t ch, const uint8_t *rgb, uint8_t *out)
+{
+	int16_t *e = q->err[ch] + PAD;
+	int16_t *after = q->err_after[ch] + PAD;
+	uint8_t bit = channel_bits[ch];
+	int16_t w = q->width;
+
+	// Serpentine order: odd rows run right to left, with the kernel mirrored
+	bool reverse = q->method == QUANT_FLOYD_STEINBERG && (q->row & 1);
+	int16_t x = reverse ? w - 1 : 0;
+	int16_t dx = reverse ? -1 : 1;
+
+	// The padding only ever takes error off the edges
+	e[-2] = e[-1] = e[w] = e[w + 1] = 0;
+
+	int16_t ahead = 0, ahead2 = 0, below_ahead = 0;
+	for (int16_t n = 0; n < w; n++, x += dx)
+	{
+		int16_t v = rgb[x * 3 + ch] + ((e[x] + ahead + 8) >> 4);
+		int16_t err;
+		if (v >= 128)
+		{
+			out[x] |= bit;
+			err = v - 255;
+		}
+		else
+		{
+			err = v;
+		}
+
+		if (q->method == QUANT_FLOYD_STEINBERG)
+		{
+			// 7/16 ahead, 3/16 behind-below, 5/16 below, 1/16 ahead-below
+			ahead = err * 7;
+			e[x - dx] += err * 3;
+			e[x] = err * 5 + below_ahead;
+			below_ahead = err;
+		}
+		else
+		{
+			// 1/8 to two pixels ahead, three below and one two rows down
+			int16_t d = err * 2;
+			ahead = ahead2 + d;
+			ahead2 = d;
+			e[x - 1] += d;
+			e[x] = d + below_ahead + after[x];
+			below_ahead = d;
+			after[x] = d;
+		}
+	}
+}
+
+void QUANT_row(GFXquantizer *q, const uint8_t *rgb, uint8_t *out)
+{
+	memset(out, 0, q->width);
+	if (q->method == QUANT_NEAREST)
+	{
+		for (uint16_t x = 0; x < q->width; x++, rgb += 3)
+			out[x] = (rgb[0] & 0x80 ? RED : 0) | (rgb[1] & 0x80 ? GREEN : 0) | (rgb[2] & 0x80 ? BLUE : 0);
+	}
+	else
+	{
+		for (uint8_t ch = 0; ch < 3; ch++)
+			diffuse(q, ch, rgb, out);
+	}
+	q->row++;
+
+	// Rows are emitted the way the pixel array stores them
+	for (uint16_t x = 0; x < q->width; x++)
+		out[x] = VGA_PIXEL(out[x]);
+}
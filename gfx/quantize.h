@@ -0,0 +1,28 @@
+#ifndef _QUANTIZE_H
+#define _QUANTIZE_H
+
+#include "pico/stdlib.h"
+
+#ifndef QUANT_MAX_WIDTH
+#define QUANT_MAX_WIDTH 320 // Widest row the error state is kept for
+#endif
+
+// Ways a 24-bit row can be reduced to the 8 colours
+#define QUANT_NEAREST 0			// Threshold each channel, no dithering
+#define QUANT_FLOYD_STEINBERG 1 // Full error diffusion, smooth gradients
+#define QUANT_ATKINSON 2		// Diffuses 3/4 of the error, keeps more contrast
+
+/// Error diffusion state for one image. Errors are kept per channel in 1/16 steps.
+typedef struct
+{
+	uint8_t method;
+	uint16_t width;
+	uint32_t row;							  ///< Rows done, odd rows run right to left
+	int16_t err[3][QUANT_MAX_WIDTH + 4];	  ///< One error row per channel, 2 pixels of padding each side
+	int16_t err_after[3][QUANT_MAX_WIDTH + 4]; ///< Atkinson only, error for the row after next
+} GFXquantizer;
+
+void QUANT_init(GFXquantizer *q, uint16_t width, uint8_t method);
+void QUANT_row(GFXquantizer *q, const uint8_t *rgb, uint8_t *out);
+
+#endif
@@ -0,0 +1,147 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "saveunder.h"
+#include "gfx.h"
+
+#include "vga.h"
+
+extern uint16_t _width;
+extern uint16_t _height;
+extern unsigned char vga_data_array[];
+
+typedef struct
+{
+	bool used;
+	int16_t x, y, w, h;
+	uint32_t offset; ///< Start of the saved pixels in the pool
+} SAVEregion;
+
+unsigned char save_pool[SAVE_POOL_SIZE] __attribute__((aligned(4)));
+SAVEregion save_regions[SAVE_MAX_REGIONS];
+
+// First fit: the lowest gap between saved regions that is large enough
+static bool allocate(uint32_t size, uint32_t *offset)
+{
+	uint32_t start = 0;
+	while (1)
+	{
+		uint32_t end = start + size;
+		if (end > SAVE_POOL_SIZE)
+			return false;
+
+		// Move past the first region overlapping [start, end), if any
+		bool clash = false;
+		for (uint8_t i = 0; i < SAVE_MAX_REGIONS; i++)
+		{
+			SAVEregion *r = &save_regions[i];
+			uint32_t rend = r->offset + (uint32_t)r->w * r->h;
+			if (r->used && r->offset < end && rend > start)
+			{
+				start = (rend + 3) & ~3u;
+				clash = true;
+				break;
+			}
+		}
+		if (!clash)
+		{
+			*offset = start;
+			return true;
+		}
+	}
+}
+
+int8_t SAVE_region(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	if (x < 0)
+	{
+		w += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		h += y;
+		y = 0;
+	}
+	if (x + w > _width)
+		w = _width - x;
+	if (y + h > _height)
+		h = _height - y;
+	if (w <= 0 || h <= 0)
+		return -1;
+
+	int8_t id = -1;
+	for (uint8_t i = 0; i < SAVE_MAX_REGIONS; i++)
+	{
+		if (!save_regions[i].used)
+		{
+			id = i;
+			break;
+		}
+	}
+	uint32_t offset;
+	if (id < 0 || !allocate((uint32_t)w * h, &offset))
+		return -1;
+
+	SAVEregion *r = &save_regions[id];
+	r->x = x;
+	r->y = y;
+	r->w = w;
+	r->h = h;
+	r->offset = offset;
+	r->used = true;
+	GFX_copyRows(&save_pool[offset], w, &vga_data_array[y * _width + x], _width, w, h);
+	return id;
+}
+
+bool SAVE_restore(int8_t id)
+{
+	if (id < 0 || id >= SAVE_MAX_REGIONS || !save_regions[id].used)
+		return false;
+	SAVEregion *r = &save_regions[id];
+	GFX_copyRows(&vga_data_array[r->y * _width + r->x], _width, &save_pool[r->offset], r->w, r->w, r->h);
+	r->used = false;
+	return true;
+}
+
+void SAVE_discard(int8_t id)
+{
+	if (id >= 0 && id < SAVE_MAX_REGIONS)
+		save_regions[id].used = false;
+}
+
+uint32_t SAVE_available(void)
+{
+	bool slot = false;
+	for (uint8_t i = 0; i < SAVE_MAX_REGIONS; i++)
+		slot |= !save_regions[i].used;
+	if (!slot)
+		return 0;
+
+	// Gaps start at the bottom of the pool or where allocate would place a region after another
+	uint32_t largest = 0;
+	for (int8_t i = -1; i < SAVE_MAX_REGIONS; i++)
+	{
+		uint32_t start = 0;
+		if (i >= 0)
+		{
+			if (!save_regions[i].used)
+				continue;
+			start = (save_regions[i].offset + (uint32_t)save_regions[i].w * save_regions[i].h + 3) & ~3u;
+		}
+		uint32_t end = SAVE_POOL_SIZE;
+		for (uint8_t j = 0; j < SAVE_MAX_REGIONS && start < end; j++)
+		{
+			SAVEregion *r = &save_regions[j];
+			uint32_t rend = r->offset + (uint32_t)r->w * r->h;
+			if (!r->used)
+				continue;
+			if (r->offset <= start && rend > start)
+				end = start; // inside another region
+			else if (r->offset > start && r->offset < end)
+				end = r->offset;
+		}
+		if (start < end && end - start > largest)
+			largest = end - start;
+	}
+	return largest;
+}
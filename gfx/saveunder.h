@@ -0,0 +1,18 @@
+#ifndef _SAVEUNDER_H
+#define _SAVEUNDER_H
+
+#include "pico/stdlib.h"
+
+#ifndef SAVE_POOL_SIZE
+#define SAVE_POOL_SIZE 16384 // Bytes of screen content that can be saved at once
+#endif
+#ifndef SAVE_MAX_REGIONS
+#define SAVE_MAX_REGIONS 8 // Regions that can be saved at once
+#endif
+
+int8_t SAVE_region(int16_t x, int16_t y, int16_t w, int16_t h);
+bool SAVE_restore(int8_t id);
+void SAVE_discard(int8_t id);
+uint32_t SAVE_available(void);
+
+#endif
@@ -0,0 +1,59 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "sprite.h"
+#include "gfx.h"
+
+#include "vga.h"
+
+extern unsigned char vga_data_array[];
+extern int16_t clip_x0;
+extern int16_t clip_y0;
+extern int16_t clip_x1;
+extern int16_t clip_y1;
+extern uint8_t gfxTarget;
+
+void SPRITE_draw(const GFXsprite *sprite, uint16_t frame, int16_t x, int16_t y)
+{
+	if (frame >= sprite->frames)
+		return;
+
+	int16_t first = y < clip_y0 ? clip_y0 - y : 0;
+	int16_t last = y + sprite->height > clip_y1 ? clip_y1 - y : sprite->height;
+	const uint32_t *rows = &sprite->rows[frame * sprite->height];
+
+	for (int16_t row = first; row < last; row++)
+	{
+		const uint8_t *p = sprite->data + rows[row];
+		uint8_t *line = &vga_data_array[(y + row) * LINE_PIXELS];
+		int16_t px = x;
+
+		for (uint8_t spans = *p++; spans; spans--)
+		{
+			px += *p++;
+			uint8_t len = *p++;
+			const uint8_t *src = p;
+			int16_t x0 = px, x1 = px + len;
+			p += len;
+			px += len;
+
+			// Spans run left to right, so nothing more of the row is visible past the clip edge
+			if (x0 >= clip_x1)
+				break;
+			if (x0 < clip_x0)
+			{
+				src += clip_x0 - x0;
+				x0 = clip_x0;
+			}
+			if (x1 > clip_x1)
+				x1 = clip_x1;
+			if (x0 >= x1)
+				continue;
+
+			// The overlay plane holds 4-bit pixels, so spans are drawn there as runs of one colour
+			if (gfxTarget == GFX_OVERLAY)
+				GFX_drawRuns(x0, y + row, src, x1 - x0, -1);
+			else
+				memcpy(&line[x0], src, x1 - x0);
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#ifndef _SPRITE_H
+#define _SPRITE_H
+
+#include "pico/stdlib.h"
+
+/// Sprite with its transparent pixels run-length coded away, as generated by tools/imgconv -e sprite.
+/// Each row is a span count followed by that many (skip, length, pixels...) spans: `skip`
+/// transparent pixels are stepped over, then `length` pixel array bytes are copied.
+typedef struct
+{
+	uint16_t width;		  ///< Frame width in pixels
+	uint16_t height;	  ///< Frame height in pixels
+	uint16_t frames;	  ///< Frames in a sprite sheet, 1 for a single sprite
+	const uint8_t *data;  ///< Encoded rows
+	const uint32_t *rows; ///< Start of each row in `data`, `height` entries per frame
+} GFXsprite;
+
+void SPRITE_draw(const GFXsprite *sprite, uint16_t frame, int16_t x, int16_t y);
+
+#endif
@@ -0,0 +1,316 @@
+#include "pico/stdlib.h"
+#include "ui.h"
+#include "gfx.h"
+
+#include "vga.h"
+
+extern uint16_t _width;
+extern uint16_t _height;
+
+UIwidget *ui_root = NULL;
+
+// Damage collected since the last render, merged as it comes in
+UIrect ui_damage[UI_MAX_DAMAGE];
+uint8_t ui_damage_count = 0;
+
+// Frame the last render happened in, to render at most once per displayed frame
+uint32_t ui_last_frame = UINT32_MAX;
+
+static inline int32_t area(const UIrect *r)
+{
+	return (int32_t)r->w * r->h;
+}
+
+static inline bool intersects(const UIrect *a, const UIrect *b)
+{
+	return a->x < b->x + b->w && b->x < a->x + a->w &&
+		   a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static inline bool contains(const UIrect *outer, const UIrect *inner)
+{
+	return inner->x >= outer->x && inner->y >= outer->y &&
+		   inner->x + inner->w <= outer->x + outer->w &&
+		   inner->y + inner->h <= outer->y + outer->h;
+}
+
+static UIrect unite(const UIrect *a, const UIrect *b)
+{
+	int16_t x0 = a->x < b->x ? a->x : b->x;
+	int16_t y0 = a->y < b->y ? a->y : b->y;
+	int16_t x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+	int16_t y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+	UIrect r = {x0, y0, x1 - x0, y1 - y0};
+	return r;
+}
+
+static bool clipTo(UIrect *r, const UIrect *c)
+{
+	int16_t x0 = r->x > c->x ? r->x : c->x;
+	int16_t y0 = r->y > c->y ? r->y : c->y;
+	int16_t x1 = r->x + r->w < c->x + c->w ? r->x + r->w : c->x + c->w;
+	int16_t y1 = r->y + r->h < c->y + c->h ? r->y + r->h : c->y + c->h;
+	r->x = x0;
+	r->y = y0;
+	r->w = x1 - x0;
+	r->h = y1 - y0;
+	return r->w > 0 && r->h > 0;
+}
+
+// Adds a damaged rectangle, merging it with the list so it stays short
+static void addDamage(UIrect r)
+{
+	UIrect screen = {0, 0, _width, _height};
+	if (!clipTo(&r, &screen))
+		return;
+
+	// Absorb every rectangle the new one touches, where the merge does not waste area
+	for (uint8_t i = 0; i < ui_damage_count;)
+	{
+		UIrect u = unite(&r, &ui_damage[i]);
+		if (contains(&r, &ui_damage[i]) || area(&u) <= area(&r) + area(&ui_damage[i]))
+		{
+			r = u;
+			ui_damage[i] = ui_damage[--ui_damage_count];
+			i = 0; // the grown rectangle may now overlap earlier entries
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	if (ui_damage_count == UI_MAX_DAMAGE)
+	{
+		// List full: merge into the entry that grows the least
+		uint8_t best = 0;
+		int32_t bestGrowth = INT32_MAX;
+		for (uint8_t i = 0; i < ui_damage_count; i++)
+		{
+			UIrect u = unite(&r, &ui_damage[i]);
+			int32_t growth = area(&u) - area(&ui_damage[i]);
+			if (growth < bestGrowth)
+			{
+				bestGrowth = growth;
+				best = i;
+			}
+		}
+		r = unite(&r, &ui_damage[best]);
+		ui_damage[best] = ui_damage[--ui_damage_count];
+		addDamage(r);
+		return;
+	}
+	ui_damage[ui_damage_count++] = r;
+}
+
+// Part of a widget that is actually on screen, after clipping by its ancestors
+static bool visibleBounds(UIwidget *w, UIrect *r)
+{
+	*r = w->bounds;
+	for (UIwidget *p = w; p; p = p->parent)
+	{
+		if (!p->visible)
+			return false;
+		if (p->parent && !clipTo(r, &p->parent->bounds))
+			return false;
+	}
+	return true;
+}
+
+void UI_init(UIwidget *w, int16_t x, int16_t y, int16_t width, int16_t height, UIdrawFn draw, void *data)
+{
+	w->bounds.x = x;
+	w->bounds.y = y;
+	w->bounds.w = width;
+	w->bounds.h = height;
+	w->z = 0;
+	w->visible = true;
+	w->opaque = false;
+	w->color = BLACK;
+	w->draw = draw;
+	w->data = data;
+	w->parent = NULL;
+	w->child = NULL;
+	w->next = NULL;
+}
+
+static void drawPanel(UIwidget *w)
+{
+	GFX_fillRect(w->bounds.x, w->bounds.y, w->bounds.w, w->bounds.h, w->color);
+}
+
+void UI_initPanel(UIwidget *w, int16_t x, int16_t y, int16_t width, int16_t height, uint16_t color)
+{
+	UI_init(w, x, y, width, height, drawPanel, NULL);
+	w->color = color;
+	w->opaque = true;
+}
+
+void UI_setRoot(UIwidget *root)
+{
+	ui_root = root;
+	ui_damage_count = 0;
+	if (root)
+		UI_invalidate(root);
+}
+
+// Links a widget into its parent's child list, keeping it sorted by z
+static void link(UIwidget *parent, UIwidget *w)
+{
+	UIwidget **pp = &parent->child;
+	while (*pp && (*pp)->z <= w->z)
+		pp = &(*pp)->next;
+	w->next = *pp;
+	*pp = w;
+	w->parent = parent;
+}
+
+static void unlink(UIwidget *w)
+{
+	if (!w->parent)
+		return;
+	UIwidget **pp = &w->parent->child;
+	while (*pp && *pp != w)
+		pp = &(*pp)->next;
+	if (*pp)
+		*pp = w->next;
+	w->next = NULL;
+}
+
+void UI_add(UIwidget *parent, UIwidget *w)
+{
+	link(parent, w);
+	UI_invalidate(w);
+}
+
+void UI_remove(UIwidget *w)
+{
+	UIrect r;
+	if (visibleBounds(w, &r))
+		addDamage(r);
+	unlink(w);
+	w->parent = NULL;
+}
+
+void UI_setBounds(UIwidget *w, int16_t x, int16_t y, int16_t width, int16_t height)
+{
+	UIrect r;
+	if (visibleBounds(w, &r))
+		addDamage(r); // uncovered area
+	w->bounds.x = x;
+	w->bounds.y = y;
+	w->bounds.w = width;
+	w->bounds.h = height;
+	UI_invalidate(w);
+}
+
+void UI_setZ(UIwidget *w, int16_t z)
+{
+	if (w->z == z)
+		return;
+	w->z = z;
+	if (w->parent)
+	{
+		UIwidget *parent = w->parent;
+		unlink(w);
+		link(parent, w);
+	}
+	UI_invalidate(w);
+}
+
+void UI_setVisible(UIwidget *w, bool visible)
+{
+	if (w->visible == visible)
+		return;
+	UIrect r;
+	if (!visible && visibleBounds(w, &r))
+		addDamage(r);
+	w->visible = visible;
+	if (visible)
+		UI_invalidate(w);
+}
+
+void UI_invalidate(UIwidget *w)
+{
+	UIrect r;
+	if (visibleBounds(w, &r))
+		addDamage(r);
+}
+
+void UI_invalidateRect(int16_t x, int16_t y, int16_t w, int16_t h)
+{
+	UIrect r = {x, y, w, h};
+	addDamage(r);
+}
+
+// Flattens the visible tree into drawing order, returns the widget count. Widgets past
+// UI_MAX_WIDGETS are counted but not listed.
+static uint16_t collect(UIwidget *w, UIwidget **list, uint16_t n)
+{
+	for (; w; w = w->next)
+	{
+		if (!w->visible)
+			continue;
+		if (n < UI_MAX_WIDGETS)
+			list[n] = w;
+		n = collect(w->child, list, n + 1);
+	}
+	return n;
+}
+
+bool UI_render(void)
+{
+	if (!ui_root || !ui_damage_count)
+		return true;
+
+	UIwidget *list[UI_MAX_WIDGETS];
+	UIrect vis[UI_MAX_WIDGETS];
+	list[0] = ui_root;
+	uint16_t n = ui_root->visible ? collect(ui_root->child, list, 1) : 0;
+	bool complete = n <= UI_MAX_WIDGETS;
+	if (!complete)
+		n = UI_MAX_WIDGETS;
+	for (uint16_t i = 0; i < n; i++)
+		visibleBounds(list[i], &vis[i]);
+
+	for (uint8_t d = 0; d < ui_damage_count; d++)
+	{
+		UIrect *r = &ui_damage[d];
+
+		// Nothing below the topmost opaque widget covering the whole rectangle shows through
+		uint16_t first = 0;
+		for (uint16_t i = n; i-- > 0;)
+		{
+			if (list[i]->opaque && contains(&vis[i], r))
+			{
+				first = i;
+				break;
+			}
+		}
+
+		for (uint16_t i = first; i < n; i++)
+		{
+			if (!list[i]->draw || !intersects(&vis[i], r))
+				continue;
+			UIrect c = vis[i];
+			clipTo(&c, r);
+			GFX_setClipRect(c.x, c.y, c.w, c.h);
+			list[i]->draw(list[i]);
+		}
+	}
+	GFX_resetClipRect();
+	ui_damage_count = 0;
+	return complete;
+}
+
+bool UI_update(bool *complete)
+{
+	uint32_t frame = VGA_getFrameCount();
+	if (frame == ui_last_frame || !ui_damage_count)
+		return false;
+	ui_last_frame = frame;
+	bool all = UI_render();
+	if (complete)
+		*complete = all;
+	return true;
+}
@@ -0,0 +1,54 @@
+#ifndef _UI_H
+#define _UI_H
+
+#include "pico/stdlib.h"
+
+#ifndef UI_MAX_DAMAGE
+#define UI_MAX_DAMAGE 16 // Damaged rectangles tracked per frame before they are merged
+#endif
+#ifndef UI_MAX_WIDGETS
+#define UI_MAX_WIDGETS 64 // Widgets the renderer can stack in one pass
+#endif
+
+/// Screen rectangle
+typedef struct
+{
+	int16_t x, y, w, h;
+} UIrect;
+
+typedef struct UIwidget UIwidget;
+
+/// Draws a widget. Drawing is clipped to the damaged area, so it may paint its whole bounds.
+typedef void (*UIdrawFn)(UIwidget *w);
+
+/// Node of the widget tree
+struct UIwidget
+{
+	UIrect bounds;		///< Position and size on screen
+	int16_t z;			///< Order among siblings, higher is drawn on top
+	bool visible;		///< Hidden widgets and their children are not drawn
+	bool opaque;		///< Paints every pixel of its bounds, widgets below it can be skipped
+	uint16_t color;		///< Used by the stock panel draw function
+	UIdrawFn draw;		///< Called to paint the widget, may be NULL for pure containers
+	void *data;			///< User data for the draw function
+	UIwidget *parent;	///< Containing widget, children are clipped to it
+	UIwidget *child;	///< First (lowest) child
+	UIwidget *next;		///< Next sibling, higher in z order
+};
+
+void UI_init(UIwidget *w, int16_t x, int16_t y, int16_t width, int16_t height, UIdrawFn draw, void *data);
+void UI_initPanel(UIwidget *w, int16_t x, int16_t y, int16_t width, int16_t height, uint16_t color);
+void UI_setRoot(UIwidget *root);
+void UI_add(UIwidget *parent, UIwidget *w);
+void UI_remove(UIwidget *w);
+
+void UI_setBounds(UIwidget *w, int16_t x, int16_t y, int16_t width, int16_t height);
+void UI_setZ(UIwidget *w, int16_t z);
+void UI_setVisible(UIwidget *w, bool visible);
+void UI_invalidate(UIwidget *w);
+void UI_invalidateRect(int16_t x, int16_t y, int16_t w, int16_t h);
+
+bool UI_render(void);
+bool UI_update(bool *complete);
+
+#endif
@@ -0,0 +1,125 @@
+#include "pico/stdlib.h"
+#include "string.h"
+#include "waterfall.h"
+
+#include "vga.h"
+
+extern unsigned char vga_data_array[];
+
+// 4x4 ordered dither thresholds, scaled to 0-255
+static const uint8_t bayer[4][4] = {
+	{8, 136, 40, 168},
+	{200, 72, 232, 104},
+	{56, 184, 24, 152},
+	{248, 120, 216, 88},
+};
+
+static const uint8_t defaultRamp[] = {BLACK, BLUE, CYAN, GREEN, YELLOW, RED, WHITE};
+
+static inline unsigned char *bandRow(GFXwaterfall *wf, uint16_t row)
+{
+	return &vga_data_array[(wf->y + row) * LINE_PIXELS];
+}
+
+// Points the band's scanlines at its rows, newest at the top
+static void updateLines(GFXwaterfall *wf)
+{
+	uint16_t row = wf->newest;
+	for (int16_t i = 0; i < wf->h; i++)
+	{
+		VGA_setLineSource(wf->y + i, bandRow(wf, row));
+		if (++row == wf->h)
+			row = 0;
+	}
+}
+
+void WF_init(GFXwaterfall *wf, int16_t y, int16_t h, int16_t x, int16_t w)
+{
+	if (y < 0)
+	{
+		h += y;
+		y = 0;
+	}
+	if (y + h > LINE_COUNT)
+		h = LINE_COUNT - y;
+	if (x < 0)
+	{
+		w += x;
+		x = 0;
+	}
+	if (x + w > LINE_PIXELS)
+		w = LINE_PIXELS - x;
+
+	wf->y = y;
+	wf->h = h > 0 ? h : 0;
+	wf->x = x;
+	wf->w = w > 0 ? w : 0;
+	wf->bg = BLACK;
+	wf->newest = 0;
+	wf->rows = 0;
+	WF_setRamp(wf, defaultRamp, sizeof(defaultRamp));
+	WF_clear(wf);
+}
+
+void WF_setRamp(GFXwaterfall *wf, const uint8_t *colors, uint8_t n)
+{
+	if (!n)
+		return;
+	for (uint16_t v = 0; v < 256; v++)
+	{
+		GFXlutEntry *e = &wf->lut[v];
+		if (n == 1)
+		{
+			e->lo = e->hi = VGA_PIXEL(colors[0]);
+			e->frac = 0;
+			continue;
+		}
+		// Position along the ramp in 8.8 fixed point
+		uint32_t pos = (uint32_t)v * (n - 1) * 256 / 255;
+		uint32_t idx = pos >> 8;
+		uint8_t frac = pos & 0xff;
+		if (idx >= (uint32_t)(n - 1))
+		{
+			idx = n - 2;
+			frac = 255;
+		}
+		e->lo = VGA_PIXEL(colors[idx]);
+		e->hi = VGA_PIXEL(colors[idx + 1]);
+		e->frac = frac;
+	}
+}
+
+void WF_setBackground(GFXwaterfall *wf, uint16_t color)
+{
+	wf->bg = color;
+}
+
+void WF_addRow(GFXwaterfall *wf, const uint8_t *values)
+{
+	if (!wf->h)
+		return;
+
+	// The oldest row is the one shown at the bottom, reuse it for the new data
+	wf->newest = wf->newest ? wf->newest - 1 : wf->h - 1;
+	unsigned char *row = bandRow(wf, wf->newest);
+	const uint8_t *thr = bayer[wf->rows++ & 3];
+
+	memset(row, VGA_PIXEL(wf->bg), wf->x);
+	unsigned char *p = row + wf->x;
+	for (int16_t i = 0; i < wf->w; i++)
+	{
+		const GFXlutEntry *e = &wf->lut[values[i]];
+		p[i] = e->frac > thr[i & 3] ? e->hi : e->lo;
+	}
+	memset(row + wf->x + wf->w, VGA_PIXEL(wf->bg), LINE_PIXELS - wf->x - wf->w);
+
+	updateLines(wf);
+}
+
+void WF_clear(GFXwaterfall *wf)
+{
+	if (wf->h)
+		memset(bandRow(wf, 0), VGA_PIXEL(wf->bg), wf->h * LINE_PIXELS);
+	wf->newest = 0;
+	updateLines(wf);
+}
@@ -0,0 +1,31 @@
+#ifndef _WATERFALL_H
+#define _WATERFALL_H
+
+#include "pico/stdlib.h"
+
+/// One level of the colour LUT, dithered between two colours
+typedef struct
+{
+	uint8_t lo;	  ///< Pixel byte used below the dither threshold
+	uint8_t hi;	  ///< Pixel byte used above the dither threshold
+	uint8_t frac; ///< Share of `hi`, 0-255
+} GFXlutEntry;
+
+/// Scrolling waterfall state. It owns whole scanlines of the screen.
+typedef struct
+{
+	int16_t y, h;		  ///< Scanlines owned by the waterfall
+	int16_t x, w;		  ///< Columns that new rows are written to
+	uint16_t bg;		  ///< Colour of the rest of each scanline
+	uint16_t newest;	  ///< Band row holding the newest data
+	uint32_t rows;		  ///< Rows added so far, selects the dither phase
+	GFXlutEntry lut[256]; ///< Value to colour mapping
+} GFXwaterfall;
+
+void WF_init(GFXwaterfall *wf, int16_t y, int16_t h, int16_t x, int16_t w);
+void WF_setRamp(GFXwaterfall *wf, const uint8_t *colors, uint8_t n);
+void WF_setBackground(GFXwaterfall *wf, uint16_t color);
+void WF_addRow(GFXwaterfall *wf, const uint8_t *values);
+void WF_clear(GFXwaterfall *wf);
+
+#endif
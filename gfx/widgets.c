@@ -0,0 +1,263 @@
+#include "pico/stdlib.h"
+#include <stdlib.h>
+#include "widgets.h"
+#include "gfx.h"
+#include "gfxmath.h"
+
+#include "vga.h"
+
+extern uint16_t _width;
+extern unsigned char vga_data_array[];
+extern int16_t clip_x0, clip_y0, clip_x1, clip_y1;
+extern uint8_t gfxTarget;
+
+#define ANGLE_UNIT 16		   // Widget angles are in 1/16 degree
+#define VEC_ONE 1024		   // Length of a unit direction vector
+
+#define METER_HUB 2
+
+// Maps a value linearly onto [0, range], clamped
+static int32_t valueToRange(int16_t value, int16_t vmin, int16_t vmax, int32_t range)
+{
+	if (value <= vmin)
+		return 0;
+	if (value >= vmax)
+		return range;
+	return (int32_t)(((int64_t)(value - vmin) * range) / (vmax - vmin));
+}
+
+// Stores a value range, an empty one made one step wide without leaving int16_t
+static void setRange(int16_t *lo, int16_t *hi, int16_t vmin, int16_t vmax)
+{
+	if (vmax <= vmin)
+	{
+		if (vmin == INT16_MAX)
+			vmin = INT16_MAX - 1;
+		vmax = vmin + 1;
+	}
+	*lo = vmin;
+	*hi = vmax;
+}
+
+static void direction(int32_t angle, int32_t *dx, int32_t *dy)
+{
+	uint16_t a = MATH_DEG16(angle);
+	*dx = (MATH_cos(a) * VEC_ONE + MATH_ONE / 2) >> 16;
+	*dy = (MATH_sin(a) * VEC_ONE + MATH_ONE / 2) >> 16;
+}
+
+// ===================================== Bar graph =====================================
+
+void BAR_init(GFXbar *b, int16_t x, int16_t y, int16_t w, int16_t h, int16_t vmin, int16_t vmax, bool vertical)
+{
+	b->x = x;
+	b->y = y;
+	b->w = w;
+	b->h = h;
+	setRange(&b->vmin, &b->vmax, vmin, vmax);
+	b->fg = GREEN;
+	b->bg = BLACK;
+	b->vertical = vertical;
+	b->filled = 0;
+}
+
+void BAR_setColors(GFXbar *b, uint16_t fg, uint16_t bg)
+{
+	b->fg = fg;
+	b->bg = bg;
+}
+
+// Paints the part of the bar between lengths `from` and `to`
+static void barSpan(GFXbar *b, int16_t from, int16_t to, uint16_t color)
+{
+	if (b->vertical)
+		GFX_fillRect(b->x, b->y + b->h - to, b->w, to - from, color);
+	else
+		GFX_fillRect(b->x + from, b->y, to - from, b->h, color);
+}
+
+void BAR_draw(GFXbar *b)
+{
+	int16_t len = b->vertical ? b->h : b->w;
+	barSpan(b, 0, b->filled, b->fg);
+	barSpan(b, b->filled, len, b->bg);
+}
+
+void BAR_setValue(GFXbar *b, int16_t value)
+{
+	int16_t len = b->vertical ? b->h : b->w;
+	int16_t filled = valueToRange(value, b->vmin, b->vmax, len);
+
+	// Only the difference between the old and the new length is painted
+	if (filled > b->filled)
+		barSpan(b, b->filled, filled, b->fg);
+	else if (filled < b->filled)
+		barSpan(b, filled, b->filled, b->bg);
+	b->filled = filled;
+}
+
+// ===================================== Arc gauge =====================================
+
+// Fills the ring between two angles. Pixels on the a0 edge are filled and those on the a1 edge
+// are not, so a partial update paints exactly what a full redraw would.
+static void fillBand(GFXgauge *g, int32_t a0, int32_t a1, uint16_t color)
+{
+	GFX_fillArc(g->cx, g->cy, g->r, g->thickness, a0, a1 - a0, color);
+}
+
+void GAUGE_init(GFXgauge *g, int16_t cx, int16_t cy, int16_t r, int16_t thickness, int16_t vmin, int16_t vmax)
+{
+	g->cx = cx;
+	g->cy = cy;
+	g->r = r;
+	g->thickness = thickness;
+	setRange(&g->vmin, &g->vmax, vmin, vmax);
+	g->fg = GREEN;
+	g->track = BLACK;
+	GAUGE_setAngles(g, 135, 270);
+}
+
+void GAUGE_setAngles(GFXgauge *g, int16_t start_deg, int16_t sweep_deg)
+{
+	if (sweep_deg > 360)
+		sweep_deg = 360;
+	start_deg %= 360;
+	if (start_deg < 0)
+		start_deg += 360;
+	g->start = start_deg * ANGLE_UNIT;
+	g->sweep = sweep_deg > 0 ? sweep_deg * ANGLE_UNIT : 0;
+	g->angle = g->start;
+}
+
+void GAUGE_setColors(GFXgauge *g, uint16_t fg, uint16_t track)
+{
+	g->fg = fg;
+	g->track = track;
+}
+
+void GAUGE_draw(GFXgauge *g)
+{
+	fillBand(g, g->start, g->angle, g->fg);
+	fillBand(g, g->angle, g->start + g->sweep, g->track);
+}
+
+void GAUGE_setValue(GFXgauge *g, int16_t value)
+{
+	int32_t angle = g->start + valueToRange(value, g->vmin, g->vmax, g->sweep);
+
+	// Only the band swept between the old and the new value is painted
+	if (angle > g->angle)
+		fillBand(g, g->angle, angle, g->fg);
+	else if (angle < g->angle)
+		fillBand(g, angle, g->angle, g->track);
+	g->angle = angle;
+}
+
+// ===================================== Needle meter =====================================
+
+// Raw pixel of the draw target: a pixel array byte, or an overlay plane nibble
+static uint8_t readPixel(int16_t x, int16_t y)
+{
+	if (gfxTarget != GFX_OVERLAY)
+		return vga_data_array[y * _width + x];
+	uint8_t *row = VGA_getOverlayRow(y);
+	if (!row)
+		return 0;
+	return (x & 1) ? row[x >> 1] >> 4 : row[x >> 1] & 0xf;
+}
+
+static void writePixel(int16_t x, int16_t y, uint8_t v)
+{
+	if (gfxTarget != GFX_OVERLAY)
+	{
+		vga_data_array[y * _width + x] = v;
+		return;
+	}
+	uint8_t *row = VGA_getOverlayRow(y);
+	if (row)
+		row[x >> 1] = (x & 1) ? (row[x >> 1] & 0x0f) | (v << 4) : (row[x >> 1] & 0xf0) | v;
+}
+
+// Walks the needle out from the hub, either keeping the pixels under it and drawing it, or
+// putting the kept pixels back. The same angle always walks the same pixels.
+static void walkNeedle(GFXmeter *m, int32_t angle, bool erase)
+{
+	int32_t dx, dy;
+	direction(angle, &dx, &dy);
+	int16_t x = m->cx;
+	int16_t y = m->cy;
+	int16_t x1 = m->cx + (dx * m->len) / VEC_ONE;
+	int16_t y1 = m->cy + (dy * m->len) / VEC_ONE;
+	int16_t ax = abs(x1 - x), sx = x1 > x ? 1 : -1;
+	int16_t ay = abs(y1 - y), sy = y1 > y ? 1 : -1;
+	int16_t err = ax - ay;
+
+	// Bresenham takes max(ax, ay) <= len steps
+	for (uint16_t i = 0;; i++)
+	{
+		if (x >= clip_x0 && y >= clip_y0 && x < clip_x1 && y < clip_y1)
+		{
+			if (erase)
+				writePixel(x, y, m->under[i]);
+			else
+			{
+				m->under[i] = readPixel(x, y);
+				GFX_drawPixel(x, y, m->needle);
+			}
+		}
+		if (x == x1 && y == y1)
+			break;
+		int16_t e2 = 2 * err;
+		if (e2 > -ay)
+		{
+			err -= ay;
+			x += sx;
+		}
+		if (e2 < ax)
+		{
+			err += ax;
+			y += sy;
+		}
+	}
+}
+
+void METER_init(GFXmeter *m, int16_t cx, int16_t cy, int16_t len, int16_t vmin, int16_t vmax)
+{
+	m->cx = cx;
+	m->cy = cy;
+	m->len = len < METER_MAX_LEN ? len : METER_MAX_LEN;
+	setRange(&m->vmin, &m->vmax, vmin, vmax);
+	m->needle = RED;
+	METER_setAngles(m, 180, 180);
+}
+
+void METER_setAngles(GFXmeter *m, int16_t start_deg, int16_t sweep_deg)
+{
+	m->start = start_deg * ANGLE_UNIT;
+	m->sweep = sweep_deg * ANGLE_UNIT;
+	m->angle = m->start;
+}
+
+void METER_setColor(GFXmeter *m, uint16_t needle)
+{
+	m->needle = needle;
+}
+
+void METER_draw(GFXmeter *m)
+{
+	walkNeedle(m, m->angle, false);
+	GFX_fillCircle(m->cx, m->cy, METER_HUB, m->needle);
+}
+
+void METER_setValue(GFXmeter *m, int16_t value)
+{
+	int32_t angle = m->start + valueToRange(value, m->vmin, m->vmax, m->sweep);
+	if (angle == m->angle)
+		return;
+
+	// Put back what was under the old needle, then keep what is under the new one as it is drawn
+	walkNeedle(m, m->angle, true);
+	walkNeedle(m, angle, false);
+	GFX_fillCircle(m->cx, m->cy, METER_HUB, m->needle);
+	m->angle = angle;
+}
@@ -0,0 +1,60 @@
+#ifndef _WIDGETS_H
+#define _WIDGETS_H
+
+#include "pico/stdlib.h"
+
+#ifndef METER_MAX_LEN
+#define METER_MAX_LEN 120 // Longest meter needle, the meter keeps a copy of the pixels under it
+#endif
+
+/// Bar graph, filled from the bottom (vertical) or the left (horizontal)
+typedef struct
+{
+	int16_t x, y, w, h;
+	int16_t vmin, vmax;
+	uint16_t fg, bg;
+	bool vertical;
+	int16_t filled; ///< Length in pixels currently painted in `fg`
+} GFXbar;
+
+/// Arc gauge, a ring sector filled from the start angle up to the value
+typedef struct
+{
+	int16_t cx, cy;
+	int16_t r, thickness;
+	int16_t vmin, vmax;
+	int32_t start, sweep; ///< Angles in 1/16 degree, clockwise from 3 o'clock
+	uint16_t fg, track;
+	int32_t angle; ///< Angle the fill currently reaches
+} GFXgauge;
+
+/// Needle meter
+typedef struct
+{
+	int16_t cx, cy;
+	int16_t len;
+	int16_t vmin, vmax;
+	int32_t start, sweep; ///< Angles in 1/16 degree, clockwise from 3 o'clock
+	uint16_t needle;
+	int32_t angle;					   ///< Angle the needle is currently drawn at
+	uint8_t under[METER_MAX_LEN + 1]; ///< Pixels the needle covers, put back to erase it
+} GFXmeter;
+
+void BAR_init(GFXbar *b, int16_t x, int16_t y, int16_t w, int16_t h, int16_t vmin, int16_t vmax, bool vertical);
+void BAR_setColors(GFXbar *b, uint16_t fg, uint16_t bg);
+void BAR_draw(GFXbar *b);
+void BAR_setValue(GFXbar *b, int16_t value);
+
+void GAUGE_init(GFXgauge *g, int16_t cx, int16_t cy, int16_t r, int16_t thickness, int16_t vmin, int16_t vmax);
+void GAUGE_setAngles(GFXgauge *g, int16_t start_deg, int16_t sweep_deg);
+void GAUGE_setColors(GFXgauge *g, uint16_t fg, uint16_t track);
+void GAUGE_draw(GFXgauge *g);
+void GAUGE_setValue(GFXgauge *g, int16_t value);
+
+void METER_init(GFXmeter *m, int16_t cx, int16_t cy, int16_t len, int16_t vmin, int16_t vmax);
+void METER_setAngles(GFXmeter *m, int16_t start_deg, int16_t sweep_deg);
+void METER_setColor(GFXmeter *m, uint16_t needle);
+void METER_draw(GFXmeter *m);
+void METER_setValue(GFXmeter *m, int16_t value);
+
+#endif
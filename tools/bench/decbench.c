@@ -0,0 +1,113 @@
+// Times the min/max decimation kernels against a plain loop and checks that they agree.
+// Builds on the host with the CMake project here. On the Pico, add this file to an executable
+// linked with the vga library: DEC_minmaxDual then runs with the core 1 worker.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "decimate.h"
+
+#if PICO_NO_HARDWARE
+#include <time.h>
+
+#define REPEATS 200
+
+static uint32_t time_us_32(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000000u + t.tv_nsec / 1000;
+}
+
+// Only the kernels are timed, so drawing isn't linked in
+void GFX_drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+}
+#else
+#define REPEATS 20
+#endif
+
+#define SAMPLES 16384
+#define COLUMNS 320
+
+static int16_t samples[SAMPLES + 1];
+static GFXenvelope fast[COLUMNS], dual[COLUMNS], naive[COLUMNS];
+
+// Column split as the kernels do it, one sample at a time
+static void naiveMinmax(const int16_t *s, uint32_t n, GFXenvelope *out, uint16_t columns)
+{
+	for (uint16_t c = 0; c < columns; c++)
+	{
+		uint32_t start = (uint64_t)n * c / columns;
+		uint32_t end = (uint64_t)n * (c + 1) / columns;
+		if (end == start)
+		{
+			start = start < n ? start : n - 1;
+			end = start + 1;
+		}
+		int16_t lo = s[start], hi = s[start];
+		for (uint32_t i = start + 1; i < end; i++)
+		{
+			if (s[i] < lo)
+				lo = s[i];
+			if (s[i] > hi)
+				hi = s[i];
+		}
+		out[c].min = lo;
+		out[c].max = hi;
+	}
+}
+
+typedef void (*Kernel)(const int16_t *, uint32_t, GFXenvelope *, uint16_t);
+
+static uint32_t timeKernel(Kernel k, const int16_t *s, uint32_t n, GFXenvelope *out)
+{
+	uint32_t start = time_us_32();
+	for (int i = 0; i < REPEATS; i++)
+		k(s, n, out, COLUMNS);
+	return time_us_32() - start;
+}
+
+int main(void)
+{
+#if !PICO_NO_HARDWARE
+	stdio_init_all();
+	sleep_ms(2000);
+	DEC_startWorker();
+#endif
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i <= SAMPLES; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		samples[i] = (int16_t)(seed >> 16);
+	}
+
+	// Odd counts, odd start addresses and fewer samples than columns all take their own paths
+	static const uint32_t counts[] = {SAMPLES, SAMPLES - 1, 1001, COLUMNS, 100, 1};
+	int failures = 0;
+	for (uint8_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+	{
+		for (uint8_t offset = 0; offset < 2; offset++)
+		{
+			const int16_t *s = samples + offset;
+			naiveMinmax(s, counts[i], naive, COLUMNS);
+			DEC_minmax(s, counts[i], fast, COLUMNS);
+			DEC_minmaxDual(s, counts[i], dual, COLUMNS);
+			if (memcmp(naive, fast, sizeof(naive)) || memcmp(naive, dual, sizeof(naive)))
+			{
+				printf("mismatch: %lu samples at offset %u\n", (unsigned long)counts[i], offset);
+				failures++;
+			}
+		}
+	}
+
+	uint32_t tNaive = timeKernel(naiveMinmax, samples, SAMPLES, naive);
+	uint32_t tFast = timeKernel(DEC_minmax, samples, SAMPLES, fast);
+	uint32_t tDual = timeKernel(DEC_minmaxDual, samples, SAMPLES, dual);
+	printf("%d samples into %d columns, %d runs\n", SAMPLES, COLUMNS, REPEATS);
+	printf("naive        %8lu us\n", (unsigned long)tNaive);
+	printf("DEC_minmax   %8lu us  %.2fx\n", (unsigned long)tFast, (double)tNaive / (tFast ? tFast : 1));
+	printf("minmaxDual   %8lu us  %.2fx\n", (unsigned long)tDual, (double)tNaive / (tDual ? tDual : 1));
+	printf(failures ? "FAILED\n" : "outputs match\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+// Stands in for vga.c on the host: the pixel array and the calls the drawing code makes
+#include <string.h>
+#include "pico/stdlib.h"
+#include "vga.h"
+
+unsigned char vga_data_array[TXCOUNT] __attribute__((aligned(4)));
+uint16_t _width = LINE_PIXELS;
+uint16_t _height = LINE_COUNT;
+
+void dma_memcpy(void *dest, void *src, size_t num)
+{
+	memmove(dest, src, num);
+}
+
+void dma_memset(void *dest, uint8_t val, size_t num)
+{
+	memset(dest, val, num);
+}
+
+void VGA_fillScreen(uint16_t color)
+{
+	memset(vga_data_array, VGA_PIXEL(color), TXCOUNT);
+}
+
+uint8_t *VGA_getOverlayRow(int16_t y)
+{
+	return NULL;
+}
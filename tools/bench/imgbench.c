@@ -0,0 +1,278 @@
+// Encodes a test picture as BMP, QOI and PackBits, then times the stream decoders on it and
+// checks what they draw against the asset tool's BMP reader and the quantizer. The picture
+// mixes gradients, flat areas, noise and repeated colours so every QOI operation occurs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "imgdec.h"
+#include "quantize.h"
+#include "image.h"
+
+#include "vga.h"
+
+#define WIDTH LINE_PIXELS
+#define HEIGHT LINE_COUNT
+#define WIDE 400 // Wider than IMG_MAX_WIDTH, the extra pixels are decoded and dropped
+#define REPEATS 50
+
+extern unsigned char vga_data_array[];
+
+static uint8_t picture[WIDE * HEIGHT * 3];
+static uint8_t expected[WIDTH * HEIGHT];
+static uint8_t file[WIDE * HEIGHT * 5 + 2048];
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void makePicture(void)
+{
+	uint32_t seed = 7;
+	for (uint32_t y = 0; y < HEIGHT; y++)
+	{
+		for (uint32_t x = 0; x < WIDE; x++)
+		{
+			uint8_t *p = &picture[(y * WIDE + x) * 3];
+			seed = seed * 1103515245 + 12345;
+			if (y < 60) // smooth gradients: small differences
+			{
+				p[0] = x * 255 / WIDE;
+				p[1] = y * 4;
+				p[2] = 255 - x * 255 / WIDE;
+			}
+			else if (y < 120) // flat blocks: runs
+			{
+				uint8_t c = ((x / 40) + (y / 20)) & 7;
+				p[0] = (c & 4) ? 220 : 30;
+				p[1] = (c & 2) ? 220 : 30;
+				p[2] = (c & 1) ? 220 : 30;
+			}
+			else if (y < 180) // a few colours revisited: index hits
+			{
+				static const uint8_t pal[5][3] = {{250, 10, 10}, {10, 250, 10}, {10, 10, 250}, {200, 200, 0}, {90, 90, 90}};
+				memcpy(p, pal[(seed >> 16) % 5], 3);
+			}
+			else // noise: full RGB and luma operations
+			{
+				p[0] = seed >> 24;
+				p[1] = p[0] + ((seed >> 8) & 31);
+				p[2] = seed >> 16;
+			}
+		}
+	}
+}
+
+// Colours the decoders should draw for rows of 24-bit pixels, `stride` pixels apart
+static void quantize(const uint8_t *rgb, uint32_t stride, uint8_t *out)
+{
+	static GFXquantizer q;
+	QUANT_init(&q, WIDTH, QUANT_NEAREST);
+	for (uint32_t y = 0; y < HEIGHT; y++)
+	{
+		QUANT_row(&q, rgb + y * stride * 3, out + y * WIDTH);
+		for (uint32_t x = 0; x < WIDTH; x++)
+			out[y * WIDTH + x] &= 7;
+	}
+}
+
+static void put32(uint8_t *p, uint32_t v, bool big)
+{
+	for (int i = 0; i < 4; i++)
+		p[i] = big ? v >> (24 - 8 * i) : v >> (8 * i);
+}
+
+static size_t encodeBMP(uint8_t *out)
+{
+	uint32_t rowBytes = (WIDTH * 3 + 3) & ~3u;
+	memset(out, 0, 54);
+	out[0] = 'B';
+	out[1] = 'M';
+	put32(&out[2], 54 + rowBytes * HEIGHT, false);
+	put32(&out[10], 54, false);
+	put32(&out[14], 40, false);
+	put32(&out[18], WIDTH, false);
+	put32(&out[22], HEIGHT, false);
+	out[26] = 1;
+	out[28] = 24;
+	for (uint32_t y = 0; y < HEIGHT; y++)
+	{
+		uint8_t *row = &out[54 + rowBytes * (HEIGHT - 1 - y)];
+		memset(row, 0, rowBytes);
+		for (uint32_t x = 0; x < WIDTH; x++)
+		{
+			const uint8_t *p = &picture[(y * WIDE + x) * 3];
+			row[x * 3] = p[2];
+			row[x * 3 + 1] = p[1];
+			row[x * 3 + 2] = p[0];
+		}
+	}
+	return 54 + rowBytes * HEIGHT;
+}
+
+// QOI as in the specification, three channels
+static size_t encodeQOI(uint8_t *out, uint32_t w)
+{
+	uint8_t *p = out;
+	memcpy(p, "qoif", 4);
+	put32(p + 4, w, true);
+	put32(p + 8, HEIGHT, true);
+	p[12] = 3;
+	p[13] = 0;
+	p += 14;
+
+	uint8_t index[64][4] = {{0}};
+	uint8_t prev[4] = {0, 0, 0, 255};
+	uint32_t run = 0, n = w * HEIGHT;
+	for (uint32_t i = 0; i < n; i++)
+	{
+		uint32_t x = i % w, y = i / w;
+		const uint8_t *s = &picture[(y * WIDE + x) * 3];
+		uint8_t px[4] = {s[0], s[1], s[2], 255};
+		if (!memcmp(px, prev, 4))
+		{
+			if (++run == 62 || i == n - 1)
+			{
+				*p++ = 0xc0 | (run - 1);
+				run = 0;
+			}
+			continue;
+		}
+		if (run)
+		{
+			*p++ = 0xc0 | (run - 1);
+			run = 0;
+		}
+		uint8_t h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) & 63;
+		if (!memcmp(index[h], px, 4))
+		{
+			*p++ = h;
+		}
+		else
+		{
+			memcpy(index[h], px, 4);
+			int8_t dr = px[0] - prev[0], dg = px[1] - prev[1], db = px[2] - prev[2];
+			int8_t rg = dr - dg, bg = db - dg;
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				*p++ = 0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+			else if (dg >= -32 && dg <= 31 && rg >= -8 && rg <= 7 && bg >= -8 && bg <= 7)
+			{
+				*p++ = 0x80 | (dg + 32);
+				*p++ = (rg + 8) << 4 | (bg + 8);
+			}
+			else
+			{
+				*p++ = 0xfe;
+				memcpy(p, px, 3);
+				p += 3;
+			}
+		}
+		memcpy(prev, px, 4);
+	}
+	memset(p, 0, 7);
+	p[7] = 1;
+	return p + 8 - out;
+}
+
+// One colour per byte, runs may cross rows
+static size_t encodePackBits(uint8_t *out)
+{
+	uint8_t *p = out;
+	uint32_t n = WIDTH * HEIGHT, i = 0;
+	while (i < n)
+	{
+		uint32_t r = 1;
+		while (i + r < n && r < 128 && expected[i + r] == expected[i])
+			r++;
+		if (r >= 3)
+		{
+			*p++ = 257 - r;
+			*p++ = expected[i];
+			i += r;
+			continue;
+		}
+		uint32_t l = 0;
+		while (i + l < n && l < 128 && !(i + l + 2 < n && expected[i + l] == expected[i + l + 1] && expected[i + l] == expected[i + l + 2]))
+			l++;
+		*p++ = l - 1;
+		memcpy(p, &expected[i], l);
+		p += l;
+		i += l;
+	}
+	return p - out;
+}
+
+typedef bool (*Decode)(const uint8_t *data, size_t size);
+
+static bool decodeBMP(const uint8_t *data, size_t size)
+{
+	IMGmemory m = {data, size, 0};
+	return IMG_drawBMP(0, 0, IMG_readMemory, &m);
+}
+
+static bool decodeQOI(const uint8_t *data, size_t size)
+{
+	IMGmemory m = {data, size, 0};
+	return IMG_drawQOI(0, 0, IMG_readMemory, &m);
+}
+
+static bool decodePackBits(const uint8_t *data, size_t size)
+{
+	IMGmemory m = {data, size, 0};
+	return IMG_drawPackBits(0, 0, WIDTH, HEIGHT, IMG_readMemory, &m);
+}
+
+static int run(const char *name, Decode decode, size_t size)
+{
+	memset(vga_data_array, 0, TXCOUNT);
+	bool ok = decode(file, size);
+	uint32_t wrong = 0;
+	for (uint32_t i = 0; i < WIDTH * HEIGHT; i++)
+		wrong += vga_data_array[i] != VGA_PIXEL(expected[i]);
+
+	double start = now();
+	for (int i = 0; i < REPEATS; i++)
+		decode(file, size);
+	double ms = (now() - start) * 1000 / REPEATS;
+
+	printf("%-10s %7zu bytes %8.3f ms  %s", name, size, ms, ok && !wrong ? "ok\n" : "FAILED");
+	if (!ok || wrong)
+		printf(" (%s, %u pixels differ)\n", ok ? "decoded" : "decoder error", wrong);
+	return ok && !wrong ? 0 : 1;
+}
+
+int main(void)
+{
+	int failures = 0;
+	makePicture();
+
+	// BMP: the asset tool's reader gives the reference pixels
+	size_t size = encodeBMP(file);
+	Image img;
+	if (!loadBMP(file, size, &img))
+		return 1;
+	static uint8_t rgb[WIDTH * HEIGHT * 3];
+	for (uint32_t i = 0; i < WIDTH * HEIGHT; i++)
+		memcpy(&rgb[i * 3], &img.rgba[i * 4], 3);
+	free(img.rgba);
+	quantize(rgb, WIDTH, expected);
+	failures += run("BMP 24", decodeBMP, size);
+
+	quantize(picture, WIDE, expected);
+	failures += run("QOI", decodeQOI, encodeQOI(file, WIDTH));
+	failures += run("QOI wide", decodeQOI, encodeQOI(file, WIDE));
+	failures += run("PackBits", decodePackBits, encodePackBits(file));
+
+	// A truncated stream has to fail rather than draw garbage
+	size = encodeQOI(file, WIDTH);
+	if (decodeQOI(file, size / 2))
+	{
+		printf("truncated QOI decoded\n");
+		failures++;
+	}
+	return failures ? 1 : 0;
+}
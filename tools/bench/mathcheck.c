@@ -0,0 +1,151 @@
+// Compares the fixed-point math functions with the C library and prints the worst error of
+// each. Fails if one is outside the accuracy the README gives for it.
+#include <stdio.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "gfxmath.h"
+
+#define SIN_LIMIT 1.5	// Q16 steps
+#define ATAN_LIMIT 1.0	// Binary angle units
+#define RECIP_LIMIT (1.0 / 32768) // Relative
+
+static uint32_t seed = 1;
+
+// Small LCG, so runs are repeatable on every host
+static uint32_t rnd(void)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed;
+}
+
+static int report(const char *name, double worst, double limit, const char *unit)
+{
+	bool ok = worst <= limit;
+	printf("%-12s worst %.3g %s (limit %.3g)  %s\n", name, worst, unit, limit, ok ? "ok" : "FAILED");
+	return ok ? 0 : 1;
+}
+
+static double checkSin(void)
+{
+	double worst = 0;
+	for (uint32_t a = 0; a < 65536; a++)
+	{
+		double r = a * 2 * M_PI / 65536;
+		double e = fabs(MATH_sin(a) - sin(r) * MATH_ONE);
+		if (e > worst)
+			worst = e;
+		e = fabs(MATH_cos(a) - cos(r) * MATH_ONE);
+		if (e > worst)
+			worst = e;
+	}
+	return worst;
+}
+
+static double atanError(int32_t y, int32_t x)
+{
+	if (!x && !y)
+		return MATH_atan2(y, x) ? 65536 : 0;
+	double ref = atan2(y, x) * 65536 / (2 * M_PI);
+	double e = fmod(MATH_atan2(y, x) - ref + 65536 * 2.5, 65536) - 32768;
+	return fabs(e);
+}
+
+static double checkAtan2(void)
+{
+	double worst = 0;
+	// Every small vector, then large and extreme ones
+	for (int32_t y = -200; y <= 200; y++)
+		for (int32_t x = -200; x <= 200; x++)
+			worst = fmax(worst, atanError(y, x));
+	for (uint32_t i = 0; i < 1000000; i++)
+	{
+		int32_t x = rnd(), y = rnd();
+		uint8_t s = rnd() % 32;
+		worst = fmax(worst, atanError(y >> s, x >> (rnd() % 32)));
+	}
+	const int32_t edges[] = {INT32_MIN, INT32_MIN + 1, -1, 0, 1, INT32_MAX};
+	for (uint8_t i = 0; i < 6; i++)
+		for (uint8_t j = 0; j < 6; j++)
+			worst = fmax(worst, atanError(edges[i], edges[j]));
+	return worst;
+}
+
+// Number of values whose square root isn't rounded down
+static uint32_t checkIsqrt(void)
+{
+	uint32_t wrong = 0;
+	for (uint32_t v = 0; v < 1u << 24; v++)
+	{
+		uint64_t r = MATH_isqrt(v);
+		wrong += r * r > v || (r + 1) * (r + 1) <= v;
+	}
+	// Either side of every square above that, and the top of the range
+	for (uint64_t r = 4096; r < 65536; r++)
+	{
+		for (int8_t d = -1; d <= 1; d++)
+		{
+			uint32_t v = r * r + d;
+			uint64_t q = MATH_isqrt(v);
+			wrong += q * q > v || (q + 1) * (q + 1) <= v;
+		}
+	}
+	wrong += MATH_isqrt(UINT32_MAX) != 65535;
+	return wrong;
+}
+
+static uint32_t checkIsqrt64(void)
+{
+	uint32_t wrong = 0;
+	for (uint32_t i = 0; i < 1000000; i++)
+	{
+		uint64_t v = ((uint64_t)rnd() << 32 | rnd()) >> (rnd() % 64);
+		uint64_t r = MATH_isqrt64(v);
+		// (r + 1)^2 doesn't fit when r is the largest root
+		wrong += r * r > v || (r < UINT32_MAX && (r + 1) * (r + 1) <= v);
+	}
+	for (uint32_t i = 0; i < 100000; i++)
+	{
+		uint64_t r = rnd() | 1ull << 31;
+		wrong += MATH_isqrt64(r * r) != r || MATH_isqrt64(r * r - 1) != r - 1;
+	}
+	wrong += MATH_isqrt64(UINT64_MAX) != UINT32_MAX;
+	return wrong;
+}
+
+static double recipError(uint32_t d)
+{
+	uint8_t shift;
+	uint32_t m = MATH_recip(d, &shift);
+	return fabs(ldexp(m, -shift) * d - 1);
+}
+
+static double checkRecip(void)
+{
+	double worst = 0;
+	for (uint32_t d = 1; d < 1u << 20; d++)
+		worst = fmax(worst, recipError(d));
+	for (uint32_t i = 0; i < 1000000; i++)
+		worst = fmax(worst, recipError(1 | rnd() >> (rnd() % 32)));
+	for (uint8_t k = 1; k < 32; k++)
+		worst = fmax(worst, fmax(recipError((1u << k) - 1), recipError((1u << k) + 1)));
+	return fmax(worst, recipError(UINT32_MAX));
+}
+
+int main(void)
+{
+	int failures = 0;
+	failures += report("sin/cos", checkSin(), SIN_LIMIT, "Q16 steps");
+	failures += report("atan2", checkAtan2(), ATAN_LIMIT, "units");
+	failures += report("isqrt", checkIsqrt(), 0, "wrong");
+	failures += report("isqrt64", checkIsqrt64(), 0, "wrong");
+	failures += report("recip", checkRecip(), RECIP_LIMIT, "relative");
+
+	uint8_t shift = 99;
+	uint32_t zero = MATH_recip(0, &shift);
+	if (zero != INT32_MAX || shift)
+	{
+		printf("recip(0) gave %u >> %u\n", zero, shift);
+		failures++;
+	}
+	return failures ? 1 : 0;
+}
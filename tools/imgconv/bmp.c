@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "image.h"
+
+static inline uint32_t le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+bool loadBMP(const uint8_t *file, size_t size, Image *img)
+{
+	if (size < 54 || file[0] != 'B' || file[1] != 'M')
+		return false;
+
+	uint32_t dataOffset = le32(&file[10]);
+	uint32_t infoSize = le32(&file[14]);
+	int32_t width = (int32_t)le32(&file[18]);
+	int32_t height = (int32_t)le32(&file[22]);
+	uint16_t bpp = le16(&file[28]);
+	uint32_t compression = le32(&file[30]);
+	uint32_t colorsUsed = le32(&file[46]);
+
+	// Bit fields compression is accepted for 32 bit images with the usual BGRA masks
+	if (width <= 0 || height == 0 || (compression != 0 && !(compression == 3 && bpp == 32)))
+	{
+		fprintf(stderr, "only uncompressed BMPs are supported\n");
+		return false;
+	}
+	if (bpp != 1 && bpp != 4 && bpp != 8 && bpp != 24 && bpp != 32)
+	{
+		fprintf(stderr, "%d bit BMPs are not supported\n", bpp);
+		return false;
+	}
+
+	bool topDown = height < 0;
+	if (topDown)
+		height = -height;
+
+	const uint8_t *palette = &file[14 + infoSize];
+	uint32_t entries = colorsUsed ? colorsUsed : (bpp <= 8 ? 1u << bpp : 0);
+	size_t rowBytes = (((size_t)width * bpp + 31) / 32) * 4;
+	if (dataOffset + rowBytes * height > size || 14 + infoSize + entries * 4 > size)
+	{
+		fprintf(stderr, "BMP is truncated\n");
+		return false;
+	}
+
+	img->width = width;
+	img->height = height;
+	img->rgba = malloc((size_t)width * height * 4);
+	for (int32_t y = 0; y < height; y++)
+	{
+		const uint8_t *row = &file[dataOffset + rowBytes * (topDown ? y : height - 1 - y)];
+		uint8_t *out = img->rgba + (size_t)y * width * 4;
+		for (int32_t x = 0; x < width; x++, out += 4)
+		{
+			const uint8_t *bgr;
+			uint32_t index;
+			switch (bpp)
+			{
+			case 1:
+				index = (row[x >> 3] >> (7 - (x & 7))) & 1;
+				break;
+			case 4:
+				index = (row[x >> 1] >> ((x & 1) ? 0 : 4)) & 0xf;
+				break;
+			case 8:
+				index = row[x];
+				break;
+			default:
+				bgr = &row[x * (bpp / 8)];
+				out[0] = bgr[2];
+				out[1] = bgr[1];
+				out[2] = bgr[0];
+				out[3] = bpp == 32 ? bgr[3] : 255;
+				continue;
+			}
+			bgr = index < entries ? &palette[index * 4] : (const uint8_t *)"\0\0\0";
+			out[0] = bgr[2];
+			out[1] = bgr[1];
+			out[2] = bgr[0];
+			out[3] = 255;
+		}
+	}
+
+	// Many writers leave the fourth byte of 32 bit pixels at zero, that's not transparency
+	if (bpp == 32)
+	{
+		size_t n = (size_t)width * height;
+		bool alpha = false;
+		for (size_t i = 0; i < n && !alpha; i++)
+			alpha = img->rgba[i * 4 + 3] != 0;
+		for (size_t i = 0; i < n && !alpha; i++)
+			img->rgba[i * 4 + 3] = 255;
+	}
+	return true;
+}
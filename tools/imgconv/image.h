@@ -0,0 +1,19 @@
+#ifndef _IMAGE_H
+#define _IMAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/// Decoded image, 4 bytes (RGBA) per pixel
+typedef struct
+{
+	uint32_t width;
+	uint32_t height;
+	uint8_t *rgba;
+} Image;
+
+bool loadPNG(const uint8_t *file, size_t size, Image *img);
+bool loadBMP(const uint8_t *file, size_t size, Image *img);
+
+#endif
@@ -0,0 +1,603 @@
+// Converts PNG and BMP images and sprite sheets into C headers holding GFXbitmap, GFXsprite
+// or GFXanimation assets in the native pixel formats, so nothing is converted on the Pico.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "image.h"
+#include "quantize.h"
+#include "bitmap.h"
+#include "anim.h"
+
+#include "vga.h"
+
+#define TILE_SIZE 8
+#define SPRITE 3 // Encoding that produces a GFXsprite rather than a GFXbitmap
+#define ANIM 4	 // Encoding that produces a GFXanimation
+#define ANIM_MERGE_GAP 5 // Unchanged pixels worth copying rather than starting a new span
+
+typedef struct
+{
+	const char *input;
+	const char *output;
+	const char *name;
+	int bpp;
+	int encoding;
+	int dither;
+	uint32_t frameWidth;
+	uint32_t frameHeight;
+	long key;
+	int color;
+	int background;
+} Options;
+
+static GFXquantizer quant;
+
+static void usage(void)
+{
+	fprintf(stderr,
+			"usage: imgconv [options] input.png|input.bmp\n"
+			"  -o file     output header (default stdout)\n"
+			"  -n name     name of the GFXbitmap (default from the input file)\n"
+			"  -b bpp      1, 3, 4 or 8 bits per pixel (default 8)\n"
+			"  -e enc      raw, rle, tiles, sprite or anim (default raw), sprites and animations are\n"
+			"              always 8 bpp, animations play the frames in order\n"
+			"  -d method   none, fs (Floyd-Steinberg) or atkinson (default none)\n"
+			"  -f WxH      frame size of a sprite sheet, frames run left to right, top to bottom\n"
+			"  -k RRGGBB   colour to treat as transparent, as well as alpha below 50%%\n"
+			"  -c FG,BG    colours (0-7) of set and clear pixels at 1 bpp (default 7,0)\n");
+	exit(1);
+}
+
+static uint8_t *readFile(const char *path, size_t *size)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	long len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	uint8_t *buf = malloc(len > 0 ? len : 1);
+	*size = fread(buf, 1, len, f);
+	fclose(f);
+	return buf;
+}
+
+// ===================================== Pixel values =====================================
+
+// Reduces the image to the value each pixel is packed as. Returns the transparent colour or -1.
+static int toValues(const Options *o, const Image *img, uint8_t *values)
+{
+	uint32_t w = img->width, h = img->height;
+	uint8_t *rgb = malloc(w * 3);
+	uint8_t *row = malloc(w);
+	bool used[8] = {false};
+	bool anyTransparent = false;
+
+	QUANT_init(&quant, w, o->dither);
+	for (uint32_t y = 0; y < h; y++)
+	{
+		const uint8_t *p = img->rgba + (size_t)y * w * 4;
+		for (uint32_t x = 0; x < w; x++, p += 4)
+		{
+			// 1 bpp images are dithered in grey, so all three channels agree
+			if (o->bpp == 1)
+				rgb[x * 3] = rgb[x * 3 + 1] = rgb[x * 3 + 2] = (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+			else
+				memcpy(&rgb[x * 3], p, 3);
+		}
+		QUANT_row(&quant, rgb, row);
+
+		p = img->rgba + (size_t)y * w * 4;
+		for (uint32_t x = 0; x < w; x++, p += 4)
+		{
+			uint8_t c = row[x] & 7;
+			bool clear = p[3] < 128 || (o->key >= 0 && ((p[0] << 16) | (p[1] << 8) | p[2]) == o->key);
+			size_t i = (size_t)y * w + x;
+			anyTransparent |= clear;
+			if (o->bpp == 1)
+				values[i] = clear ? 0 : c != 0;
+			else if (clear)
+				values[i] = VGA_TRANSPARENT;
+			else
+			{
+				values[i] = c;
+				used[c] = true;
+			}
+		}
+	}
+	free(rgb);
+	free(row);
+
+	if (!anyTransparent)
+		return -1;
+	if (o->bpp == 1)
+		return o->background;
+	if (o->bpp == 4 || o->encoding == SPRITE || o->encoding == ANIM)
+		return -1; // The nibble value or the spans themselves mark transparency
+
+	// 3 and 8 bpp pixels need a colour the image doesn't use to stand for transparency
+	int key = -1;
+	for (int c = 0; c < 8 && key < 0; c++)
+		if (!used[c])
+			key = c;
+	if (key < 0)
+	{
+		fprintf(stderr, "all 8 colours are used, there's none left for transparency; use -b 4\n");
+		exit(1);
+	}
+	size_t n = (size_t)w * h;
+	for (size_t i = 0; i < n; i++)
+		if (values[i] == VGA_TRANSPARENT)
+			values[i] = key;
+	return key;
+}
+
+// ===================================== Packing =====================================
+
+static size_t rowBytes(uint32_t w, int bpp)
+{
+	return ((size_t)w * bpp + 7) / 8;
+}
+
+// Packs `w` values the way BITMAP_draw unpacks them
+static void packRow(const uint8_t *values, uint32_t w, int bpp, uint8_t *out)
+{
+	memset(out, 0, rowBytes(w, bpp));
+	for (uint32_t i = 0; i < w; i++)
+	{
+		uint8_t v = values[i];
+		switch (bpp)
+		{
+		case 1:
+			out[i >> 3] |= v << (7 - (i & 7));
+			break;
+		case 3:
+			for (int b = 0; b < 3; b++)
+			{
+				uint32_t bit = i * 3 + b;
+				if ((v >> (2 - b)) & 1)
+					out[bit >> 3] |= 0x80 >> (bit & 7);
+			}
+			break;
+		case 4:
+			out[i >> 1] |= v << ((i & 1) ? 4 : 0);
+			break;
+		default:
+			out[i] = VGA_PIXEL(v);
+			break;
+		}
+	}
+}
+
+// PackBits: repeats of 3 or more become a run, everything else is copied as literals
+static size_t packBits(const uint8_t *in, size_t n, uint8_t *out)
+{
+	size_t len = 0, i = 0;
+	while (i < n)
+	{
+		size_t run = 1;
+		while (i + run < n && run < 128 && in[i + run] == in[i])
+			run++;
+		if (run >= 3)
+		{
+			out[len++] = (uint8_t)(1 - (int)run);
+			out[len++] = in[i];
+			i += run;
+			continue;
+		}
+
+		size_t start = i, count = 0;
+		while (i < n && count < 128)
+		{
+			if (i + 2 < n && in[i] == in[i + 1] && in[i] == in[i + 2])
+				break;
+			i++;
+			count++;
+		}
+		out[len++] = count - 1;
+		memcpy(&out[len], &in[start], count);
+		len += count;
+	}
+	return len;
+}
+
+// Encodes a row as (skip, length, pixels...) spans after a span count, dropping transparent pixels
+static size_t spriteRow(const uint8_t *values, uint32_t w, uint8_t *out)
+{
+	size_t len = 1;
+	uint8_t spans = 0;
+	uint32_t i = 0;
+	for (;;)
+	{
+		uint32_t skip = 0;
+		while (i + skip < w && values[i + skip] == VGA_TRANSPARENT)
+			skip++;
+		i += skip;
+		if (i == w)
+			break;
+
+		// Gaps longer than a byte are bridged with empty spans
+		for (; skip > 255; skip -= 255, spans++)
+		{
+			out[len++] = 255;
+			out[len++] = 0;
+		}
+		uint32_t count = 0;
+		while (i + count < w && count < 255 && values[i + count] != VGA_TRANSPARENT)
+			count++;
+		out[len++] = skip;
+		out[len++] = count;
+		for (uint32_t n = 0; n < count; n++)
+			out[len++] = VGA_PIXEL(values[i + n]);
+		i += count;
+		spans++;
+	}
+	out[0] = spans;
+	return len;
+}
+
+// Encodes the change from `prev` to `cur` as a delta, or as a keyframe when that is no larger
+static size_t animRecord(const uint8_t *prev, const uint8_t *cur, uint32_t w, uint32_t h, uint32_t stride, uint8_t *out)
+{
+	size_t key = 1 + (size_t)w * h;
+	size_t len = 3;
+	uint16_t spans = 0;
+
+	for (uint32_t y = 0; prev && y < h && len < key; y++)
+	{
+		const uint8_t *a = &prev[y * stride], *b = &cur[y * stride];
+		for (uint32_t x = 0; x < w && len < key;)
+		{
+			if (a[x] == b[x])
+			{
+				x++;
+				continue;
+			}
+			// Extend the span over short unchanged gaps, each new span costs 6 bytes
+			uint32_t last = x;
+			for (uint32_t j = x + 1; j < w && j - last <= ANIM_MERGE_GAP; j++)
+				if (a[j] != b[j])
+					last = j;
+			uint32_t n = last - x + 1;
+			if (len + 6 + n >= key)
+			{
+				len = key;
+				break;
+			}
+			out[len] = y & 0xff;
+			out[len + 1] = y >> 8;
+			out[len + 2] = x & 0xff;
+			out[len + 3] = x >> 8;
+			out[len + 4] = n & 0xff;
+			out[len + 5] = n >> 8;
+			for (uint32_t i = 0; i < n; i++)
+				out[len + 6 + i] = VGA_PIXEL(b[x + i] & 7);
+			len += 6 + n;
+			spans++;
+			x = last + 1;
+		}
+	}
+
+	if (!prev || len >= key)
+	{
+		out[0] = ANIM_KEY;
+		for (uint32_t y = 0; y < h; y++)
+			for (uint32_t x = 0; x < w; x++)
+				out[1 + y * w + x] = VGA_PIXEL(cur[y * stride + x] & 7);
+		return key;
+	}
+	out[0] = ANIM_DELTA;
+	out[1] = spans & 0xff;
+	out[2] = spans >> 8;
+	return len;
+}
+
+// ===================================== Output =====================================
+
+static void writeBytes(FILE *f, const char *type, const char *name, const char *suffix, const void *data, size_t n, int size)
+{
+	fprintf(f, "static const %s %s_%s[%zu] __attribute__((aligned(4))) = {", type, name, suffix, n);
+	for (size_t i = 0; i < n; i++)
+	{
+		if (i % (size == 1 ? 16 : 8) == 0)
+			fprintf(f, "\n\t");
+		if (size == 1)
+			fprintf(f, "0x%02x,", ((const uint8_t *)data)[i]);
+		else if (size == 2)
+			fprintf(f, "%u,", ((const uint16_t *)data)[i]);
+		else
+			fprintf(f, "%u,", ((const uint32_t *)data)[i]);
+		if ((i + 1) % (size == 1 ? 16 : 8) && i + 1 < n)
+			fprintf(f, " ");
+	}
+	fprintf(f, "\n};\n\n");
+}
+
+static char *defaultName(const char *path)
+{
+	const char *base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	char *name = malloc(strlen(base) + 2);
+	char *p = name;
+	if (isdigit((unsigned char)*base))
+		*p++ = '_';
+	for (; *base && *base != '.'; base++)
+		*p++ = isalnum((unsigned char)*base) ? *base : '_';
+	*p = 0;
+	return name;
+}
+
+static void parseArgs(int argc, char **argv, Options *o)
+{
+	memset(o, 0, sizeof(*o));
+	o->bpp = 8;
+	o->encoding = BITMAP_RAW;
+	o->dither = QUANT_NEAREST;
+	o->key = -1;
+	o->color = WHITE;
+	o->background = BLACK;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char *a = argv[i];
+		if (a[0] != '-')
+		{
+			if (o->input)
+				usage();
+			o->input = a;
+			continue;
+		}
+		if (!a[1] || a[2] || i + 1 >= argc)
+			usage();
+		const char *v = argv[++i];
+		switch (a[1])
+		{
+		case 'o':
+			o->output = v;
+			break;
+		case 'n':
+			o->name = v;
+			break;
+		case 'b':
+			o->bpp = atoi(v);
+			if (o->bpp != 1 && o->bpp != 3 && o->bpp != 4 && o->bpp != 8)
+				usage();
+			break;
+		case 'e':
+			if (!strcmp(v, "raw"))
+				o->encoding = BITMAP_RAW;
+			else if (!strcmp(v, "rle"))
+				o->encoding = BITMAP_RLE;
+			else if (!strcmp(v, "tiles"))
+				o->encoding = BITMAP_TILES;
+			else if (!strcmp(v, "sprite"))
+				o->encoding = SPRITE;
+			else if (!strcmp(v, "anim"))
+				o->encoding = ANIM;
+			else
+				usage();
+			break;
+		case 'd':
+			if (!strcmp(v, "none"))
+				o->dither = QUANT_NEAREST;
+			else if (!strcmp(v, "fs"))
+				o->dither = QUANT_FLOYD_STEINBERG;
+			else if (!strcmp(v, "atkinson"))
+				o->dither = QUANT_ATKINSON;
+			else
+				usage();
+			break;
+		case 'f':
+			if (sscanf(v, "%ux%u", &o->frameWidth, &o->frameHeight) != 2 || !o->frameWidth || !o->frameHeight)
+				usage();
+			break;
+		case 'k':
+			o->key = strtol(v, NULL, 16);
+			break;
+		case 'c':
+			if (sscanf(v, "%d,%d", &o->color, &o->background) != 2 || o->color < 0 || o->color > 7 ||
+				o->background < 0 || o->background > 7)
+				usage();
+			break;
+		default:
+			usage();
+		}
+	}
+	if (!o->input)
+		usage();
+	if (o->encoding == SPRITE || o->encoding == ANIM)
+		o->bpp = 8;
+}
+
+int main(int argc, char **argv)
+{
+	Options o;
+	parseArgs(argc, argv, &o);
+
+	size_t size;
+	uint8_t *file = readFile(o.input, &size);
+	if (!file)
+	{
+		fprintf(stderr, "can't read %s\n", o.input);
+		return 1;
+	}
+	Image img;
+	if (!loadPNG(file, size, &img) && !loadBMP(file, size, &img))
+	{
+		fprintf(stderr, "%s isn't a PNG or BMP that can be read\n", o.input);
+		return 1;
+	}
+	free(file);
+
+	if (img.width > QUANT_MAX_WIDTH)
+	{
+		fprintf(stderr, "image is wider than %d pixels\n", QUANT_MAX_WIDTH);
+		return 1;
+	}
+	uint32_t fw = o.frameWidth ? o.frameWidth : img.width;
+	uint32_t fh = o.frameHeight ? o.frameHeight : img.height;
+	if (fw > img.width || fh > img.height || fw > UINT16_MAX || fh > UINT16_MAX)
+	{
+		fprintf(stderr, "frame size is larger than the image\n");
+		return 1;
+	}
+	uint32_t across = img.width / fw;
+	uint32_t frames = across * (img.height / fh);
+
+	uint8_t *values = malloc((size_t)img.width * img.height);
+	int transparent = toValues(&o, &img, values);
+
+	// Worst case for every encoding is a little over the packed size of the sheet
+	size_t bytes = rowBytes(fw, o.bpp);
+	uint32_t tilesAcross = (fw + TILE_SIZE - 1) / TILE_SIZE;
+	uint32_t tilesDown = (fh + TILE_SIZE - 1) / TILE_SIZE;
+	size_t capacity = (size_t)frames * (tilesAcross * TILE_SIZE) * (tilesDown * TILE_SIZE) * 2 + (size_t)frames * fh * 8;
+	uint8_t *data = malloc(capacity);
+	uint16_t *map = malloc((size_t)frames * tilesAcross * tilesDown * sizeof(uint16_t));
+	uint32_t *offsets = malloc(((size_t)frames * fh + 1) * sizeof(uint32_t));
+	uint8_t *packed = malloc(bytes + TILE_SIZE);
+	size_t frameSize = (size_t)tilesAcross * TILE_SIZE * tilesDown * TILE_SIZE;
+	uint8_t *frameValues = calloc(frameSize, 1);
+	uint8_t *firstValues = malloc(frameSize);
+	uint8_t *prevValues = malloc(frameSize);
+	size_t len = 0, mapLen = 0, tiles = 0;
+
+	for (uint32_t f = 0; f < frames; f++)
+	{
+		// Copy the frame out of the sheet, padded to whole tiles
+		uint32_t fx = (f % across) * fw, fy = (f / across) * fh;
+		uint32_t stride = tilesAcross * TILE_SIZE;
+		for (uint32_t y = 0; y < fh; y++)
+			memcpy(&frameValues[y * stride], &values[(size_t)(fy + y) * img.width + fx], fw);
+
+		switch (o.encoding)
+		{
+		case BITMAP_RAW:
+			offsets[f] = len;
+			for (uint32_t y = 0; y < fh; y++, len += bytes)
+				packRow(&frameValues[y * stride], fw, o.bpp, &data[len]);
+			break;
+		case BITMAP_RLE:
+			offsets[f] = len;
+			for (uint32_t y = 0; y < fh; y++)
+			{
+				packRow(&frameValues[y * stride], fw, o.bpp, packed);
+				len += packBits(packed, bytes, &data[len]);
+			}
+			break;
+		case BITMAP_TILES:
+			offsets[f] = mapLen;
+			for (uint32_t ty = 0; ty < tilesDown; ty++)
+			{
+				for (uint32_t tx = 0; tx < tilesAcross; tx++)
+				{
+					uint8_t tile[TILE_SIZE * 8];
+					size_t tileBytes = TILE_SIZE * o.bpp;
+					for (uint32_t y = 0; y < TILE_SIZE; y++)
+						packRow(&frameValues[(ty * TILE_SIZE + y) * stride + tx * TILE_SIZE], TILE_SIZE, o.bpp, &tile[y * o.bpp]);
+
+					// Identical tiles anywhere in the sheet are stored once
+					size_t t = 0;
+					while (t < tiles && memcmp(&data[t * tileBytes], tile, tileBytes))
+						t++;
+					if (t == tiles)
+					{
+						if (tiles > UINT16_MAX)
+						{
+							fprintf(stderr, "too many distinct tiles\n");
+							return 1;
+						}
+						memcpy(&data[len], tile, tileBytes);
+						len += tileBytes;
+						tiles++;
+					}
+					map[mapLen++] = t;
+				}
+			}
+			break;
+		case SPRITE:
+			// Sprites index every row, so clipped rows are skipped without decoding
+			for (uint32_t y = 0; y < fh; y++)
+			{
+				offsets[f * fh + y] = len;
+				len += spriteRow(&frameValues[y * stride], fw, &data[len]);
+			}
+			break;
+		case ANIM:
+			offsets[f] = len;
+			len += animRecord(f ? prevValues : NULL, frameValues, fw, fh, stride, &data[len]);
+			if (!f)
+				memcpy(firstValues, frameValues, frameSize);
+			memcpy(prevValues, frameValues, frameSize);
+			break;
+		}
+	}
+
+	// Animations end with the change from the last frame back to the first, for looping
+	if (o.encoding == ANIM)
+	{
+		offsets[frames] = len;
+		len += animRecord(prevValues, firstValues, fw, fh, tilesAcross * TILE_SIZE, &data[len]);
+	}
+
+	FILE *out = o.output ? fopen(o.output, "w") : stdout;
+	if (!out)
+	{
+		fprintf(stderr, "can't write %s\n", o.output);
+		return 1;
+	}
+	char *name = o.name ? (char *)o.name : defaultName(o.input);
+	static const char *encodings[] = {"BITMAP_RAW", "BITMAP_RLE", "BITMAP_TILES"};
+
+	fprintf(out, "// Generated by imgconv from %s, do not edit\n", o.input);
+	fprintf(out, "// %ux%u, %u frame%s, %d bpp, %zu bytes\n", fw, fh, frames, frames == 1 ? "" : "s", o.bpp, len);
+	fprintf(out, "#ifndef _");
+	for (const char *p = name; *p; p++)
+		fputc(toupper((unsigned char)*p), out);
+	fprintf(out, "_ASSET_H\n#define _");
+	for (const char *p = name; *p; p++)
+		fputc(toupper((unsigned char)*p), out);
+	fprintf(out, "_ASSET_H\n\n#include \"%s.h\"\n\n", o.encoding == SPRITE ? "sprite" : o.encoding == ANIM ? "anim" : "bitmap");
+
+	if (o.encoding == ANIM)
+	{
+		writeBytes(out, "uint8_t", name, "data", data, len, 1);
+		writeBytes(out, "uint32_t", name, "offsets", offsets, frames + 1, 4);
+		fprintf(out, "static const GFXanimation %s = {%u, %u, %u, %s_data, %s_offsets};\n\n#endif\n", name, fw, fh, frames, name, name);
+		if (out != stdout)
+			fclose(out);
+		fprintf(stderr, "%s: %ux%u, %u frame%s, %zu bytes\n", name, fw, fh, frames, frames == 1 ? "" : "s", len);
+		return 0;
+	}
+
+	if (o.encoding == SPRITE)
+	{
+		writeBytes(out, "uint8_t", name, "data", data, len, 1);
+		writeBytes(out, "uint32_t", name, "rows", offsets, (size_t)frames * fh, 4);
+		fprintf(out, "static const GFXsprite %s = {%u, %u, %u, %s_data, %s_rows};\n\n#endif\n", name, fw, fh, frames, name, name);
+		if (out != stdout)
+			fclose(out);
+		fprintf(stderr, "%s: %ux%u, %u frame%s, %zu bytes\n", name, fw, fh, frames, frames == 1 ? "" : "s", len);
+		return 0;
+	}
+
+	writeBytes(out, "uint8_t", name, "data", data, len, 1);
+	writeBytes(out, "uint32_t", name, "offsets", offsets, frames, 4);
+	if (o.encoding == BITMAP_TILES)
+		writeBytes(out, "uint16_t", name, "map", map, mapLen, 2);
+
+	fprintf(out, "static const GFXbitmap %s = {\n", name);
+	fprintf(out, "\t%u, %u, %u, %d, %s,\n", fw, fh, frames, o.bpp, encodings[o.encoding]);
+	fprintf(out, "\t%d, %d, %d,\n", o.color, o.background, transparent);
+	fprintf(out, "\t%s_data, %s_offsets, %s%s};\n\n#endif\n", name, name, o.encoding == BITMAP_TILES ? name : "NULL",
+			o.encoding == BITMAP_TILES ? "_map" : "");
+	if (out != stdout)
+		fclose(out);
+
+	fprintf(stderr, "%s: %ux%u, %u frame%s, %zu bytes", name, fw, fh, frames, frames == 1 ? "" : "s", len);
+	if (o.encoding == BITMAP_TILES)
+		fprintf(stderr, " in %zu distinct tiles", tiles);
+	fprintf(stderr, "\n");
+	return 0;
+}
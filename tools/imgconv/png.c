@@ -0,0 +1,491 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "image.h"
+
+// ===================================== Inflate =====================================
+
+#define MAX_BITS 15
+#define MAX_LIT_CODES 286
+#define MAX_DIST_CODES 30
+#define FIXED_LIT_CODES 288
+
+typedef struct
+{
+	const uint8_t *in;
+	size_t inLen;
+	size_t inPos;
+	uint32_t bitBuf;
+	int bitCount;
+	uint8_t *out;
+	size_t outLen;
+	size_t outPos;
+	bool error;
+} Inflate;
+
+/// Canonical Huffman code: number of codes of each length and the symbols in code order
+typedef struct
+{
+	uint16_t count[MAX_BITS + 1];
+	uint16_t symbol[FIXED_LIT_CODES];
+} Huffman;
+
+static const uint16_t lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+										35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+										3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+									  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+									  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Deflate packs bits least significant first
+static uint32_t bits(Inflate *s, int need)
+{
+	while (s->bitCount < need)
+	{
+		if (s->inPos >= s->inLen)
+		{
+			s->error = true;
+			return 0;
+		}
+		s->bitBuf |= (uint32_t)s->in[s->inPos++] << s->bitCount;
+		s->bitCount += 8;
+	}
+	uint32_t v = s->bitBuf & ((1u << need) - 1);
+	s->bitBuf >>= need;
+	s->bitCount -= need;
+	return v;
+}
+
+static bool build(Huffman *h, const uint8_t *lengths, int n)
+{
+	uint16_t offs[MAX_BITS + 1];
+	memset(h->count, 0, sizeof(h->count));
+	for (int i = 0; i < n; i++)
+		h->count[lengths[i]]++;
+	if (h->count[0] == n)
+		return true;
+
+	// Reject over-subscribed codes, incomplete ones are allowed
+	int left = 1;
+	for (int len = 1; len <= MAX_BITS; len++)
+	{
+		left = (left << 1) - h->count[len];
+		if (left < 0)
+			return false;
+	}
+
+	offs[1] = 0;
+	for (int len = 1; len < MAX_BITS; len++)
+		offs[len + 1] = offs[len] + h->count[len];
+	for (int i = 0; i < n; i++)
+		if (lengths[i])
+			h->symbol[offs[lengths[i]]++] = i;
+	return true;
+}
+
+// Walks the code one bit at a time, codes are stored most significant bit first
+static int decode(Inflate *s, const Huffman *h)
+{
+	int code = 0, first = 0, index = 0;
+	for (int len = 1; len <= MAX_BITS; len++)
+	{
+		code |= bits(s, 1);
+		if (s->error)
+			return -1;
+		int count = h->count[len];
+		if (code - count < first)
+			return h->symbol[index + (code - first)];
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+	s->error = true;
+	return -1;
+}
+
+static bool codes(Inflate *s, const Huffman *lit, const Huffman *dist)
+{
+	for (;;)
+	{
+		int sym = decode(s, lit);
+		if (sym < 0)
+			return false;
+		if (sym < 256)
+		{
+			if (s->outPos >= s->outLen)
+				return false;
+			s->out[s->outPos++] = sym;
+		}
+		else if (sym == 256)
+		{
+			return true;
+		}
+		else
+		{
+			sym -= 257;
+			if (sym >= 29)
+				return false;
+			size_t len = lengthBase[sym] + bits(s, lengthExtra[sym]);
+			int d = decode(s, dist);
+			if (d < 0 || d >= 30)
+				return false;
+			size_t back = distBase[d] + bits(s, distExtra[d]);
+			if (s->error || back > s->outPos || len > s->outLen - s->outPos)
+				return false;
+			for (; len; len--, s->outPos++)
+				s->out[s->outPos] = s->out[s->outPos - back];
+		}
+	}
+}
+
+static bool stored(Inflate *s)
+{
+	s->bitBuf = 0;
+	s->bitCount = 0;
+	if (s->inPos + 4 > s->inLen)
+		return false;
+	uint16_t len = s->in[s->inPos] | (s->in[s->inPos + 1] << 8);
+	uint16_t nlen = s->in[s->inPos + 2] | (s->in[s->inPos + 3] << 8);
+	s->inPos += 4;
+	if ((len ^ nlen) != 0xffff || len > s->inLen - s->inPos || len > s->outLen - s->outPos)
+		return false;
+	memcpy(&s->out[s->outPos], &s->in[s->inPos], len);
+	s->inPos += len;
+	s->outPos += len;
+	return true;
+}
+
+static bool fixed(Inflate *s)
+{
+	static Huffman lit, dist;
+	static bool built;
+	if (!built)
+	{
+		uint8_t lengths[FIXED_LIT_CODES];
+		int i = 0;
+		for (; i < 144; i++)
+			lengths[i] = 8;
+		for (; i < 256; i++)
+			lengths[i] = 9;
+		for (; i < 280; i++)
+			lengths[i] = 7;
+		for (; i < FIXED_LIT_CODES; i++)
+			lengths[i] = 8;
+		build(&lit, lengths, FIXED_LIT_CODES);
+		memset(lengths, 5, MAX_DIST_CODES);
+		build(&dist, lengths, MAX_DIST_CODES);
+		built = true;
+	}
+	return codes(s, &lit, &dist);
+}
+
+static bool dynamic(Inflate *s)
+{
+	static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+	uint8_t lengths[MAX_LIT_CODES + MAX_DIST_CODES];
+	Huffman lencode, lit, dist;
+
+	int nlen = bits(s, 5) + 257;
+	int ndist = bits(s, 5) + 1;
+	int ncode = bits(s, 4) + 4;
+	if (s->error || nlen > MAX_LIT_CODES || ndist > MAX_DIST_CODES)
+		return false;
+
+	memset(lengths, 0, 19);
+	for (int i = 0; i < ncode; i++)
+		lengths[order[i]] = bits(s, 3);
+	if (s->error || !build(&lencode, lengths, 19))
+		return false;
+
+	// Literal and distance code lengths, themselves run-length coded
+	for (int i = 0; i < nlen + ndist;)
+	{
+		int sym = decode(s, &lencode);
+		if (sym < 0)
+			return false;
+		if (sym < 16)
+		{
+			lengths[i++] = sym;
+			continue;
+		}
+		uint8_t len = 0;
+		int repeat;
+		if (sym == 16)
+		{
+			if (i == 0)
+				return false;
+			len = lengths[i - 1];
+			repeat = 3 + bits(s, 2);
+		}
+		else if (sym == 17)
+		{
+			repeat = 3 + bits(s, 3);
+		}
+		else
+		{
+			repeat = 11 + bits(s, 7);
+		}
+		if (s->error || i + repeat > nlen + ndist)
+			return false;
+		while (repeat--)
+			lengths[i++] = len;
+	}
+	if (!lengths[256])
+		return false;
+
+	if (!build(&lit, lengths, nlen) || !build(&dist, lengths + nlen, ndist))
+		return false;
+	return codes(s, &lit, &dist);
+}
+
+// Inflates a zlib stream into `out`, returns the number of bytes produced or -1
+static long inflateZlib(const uint8_t *in, size_t inLen, uint8_t *out, size_t outLen)
+{
+	if (inLen < 2 || (in[0] & 0x0f) != 8 || ((in[0] << 8) | in[1]) % 31 || (in[1] & 0x20))
+		return -1;
+
+	Inflate s = {in, inLen, 2, 0, 0, out, outLen, 0, false};
+	bool last;
+	do
+	{
+		last = bits(&s, 1);
+		int type = bits(&s, 2);
+		bool ok;
+		if (s.error)
+			return -1;
+		switch (type)
+		{
+		case 0:
+			ok = stored(&s);
+			break;
+		case 1:
+			ok = fixed(&s);
+			break;
+		case 2:
+			ok = dynamic(&s);
+			break;
+		default:
+			ok = false;
+			break;
+		}
+		if (!ok || s.error)
+			return -1;
+	} while (!last);
+	return (long)s.outPos;
+}
+
+// ===================================== PNG =====================================
+
+#define PNG_GRAY 0
+#define PNG_RGB 2
+#define PNG_PALETTE 3
+#define PNG_GRAY_ALPHA 4
+#define PNG_RGBA 6
+
+static inline uint32_t be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+// Reverses the per-row filters in place, rows start with their filter type byte
+static bool unfilter(uint8_t *data, uint32_t height, size_t stride, int bpp)
+{
+	uint8_t *prev = NULL;
+	for (uint32_t y = 0; y < height; y++)
+	{
+		uint8_t type = data[0];
+		uint8_t *row = data + 1;
+		for (size_t i = 0; i < stride; i++)
+		{
+			uint8_t a = i >= (size_t)bpp ? row[i - bpp] : 0;
+			uint8_t b = prev ? prev[i] : 0;
+			uint8_t c = prev && i >= (size_t)bpp ? prev[i - bpp] : 0;
+			switch (type)
+			{
+			case 0:
+				break;
+			case 1:
+				row[i] += a;
+				break;
+			case 2:
+				row[i] += b;
+				break;
+			case 3:
+				row[i] += (a + b) >> 1;
+				break;
+			case 4:
+				row[i] += paeth(a, b, c);
+				break;
+			default:
+				return false;
+			}
+		}
+		prev = row;
+		data += stride + 1;
+	}
+	return true;
+}
+
+// Sample `i` of a row, scaled to 8 bits. 16 bit samples keep their high byte.
+static inline uint8_t sample(const uint8_t *row, uint32_t i, int depth, bool scale)
+{
+	switch (depth)
+	{
+	case 16:
+		return row[i * 2];
+	case 8:
+		return row[i];
+	default:
+	{
+		uint32_t bit = i * depth;
+		uint8_t v = (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
+		return scale ? v * 255 / ((1 << depth) - 1) : v;
+	}
+	}
+}
+
+bool loadPNG(const uint8_t *file, size_t size, Image *img)
+{
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	if (size < 8 || memcmp(file, signature, 8))
+		return false;
+
+	uint32_t width = 0, height = 0;
+	int depth = 0, type = 0, interlace = 0;
+	uint8_t palette[256][4];
+	memset(palette, 0xff, sizeof(palette));
+	uint8_t *idat = NULL;
+	size_t idatLen = 0;
+	bool seenHeader = false;
+
+	// Collect the header, palette, transparency and concatenated image data
+	size_t pos = 8;
+	while (pos + 12 <= size)
+	{
+		uint32_t len = be32(&file[pos]);
+		const uint8_t *tag = &file[pos + 4];
+		const uint8_t *body = &file[pos + 8];
+		if (len > size - pos - 12)
+			break;
+		if (!memcmp(tag, "IHDR", 4) && len >= 13)
+		{
+			width = be32(body);
+			height = be32(body + 4);
+			depth = body[8];
+			type = body[9];
+			interlace = body[12];
+			seenHeader = true;
+		}
+		else if (!memcmp(tag, "PLTE", 4))
+		{
+			for (uint32_t i = 0; i < len / 3 && i < 256; i++)
+				memcpy(palette[i], &body[i * 3], 3);
+		}
+		else if (!memcmp(tag, "tRNS", 4) && type == PNG_PALETTE)
+		{
+			for (uint32_t i = 0; i < len && i < 256; i++)
+				palette[i][3] = body[i];
+		}
+		else if (!memcmp(tag, "IDAT", 4))
+		{
+			idat = realloc(idat, idatLen + len);
+			memcpy(idat + idatLen, body, len);
+			idatLen += len;
+		}
+		else if (!memcmp(tag, "IEND", 4))
+		{
+			break;
+		}
+		pos += len + 12;
+	}
+
+	if (!seenHeader || !idat || !width || !height)
+	{
+		fprintf(stderr, "PNG has no image data\n");
+		free(idat);
+		return false;
+	}
+	if (interlace)
+	{
+		fprintf(stderr, "interlaced PNGs are not supported, save it without interlacing\n");
+		free(idat);
+		return false;
+	}
+
+	int channels;
+	switch (type)
+	{
+	case PNG_GRAY:
+	case PNG_PALETTE:
+		channels = 1;
+		break;
+	case PNG_GRAY_ALPHA:
+		channels = 2;
+		break;
+	case PNG_RGB:
+		channels = 3;
+		break;
+	case PNG_RGBA:
+		channels = 4;
+		break;
+	default:
+		fprintf(stderr, "unknown PNG colour type %d\n", type);
+		free(idat);
+		return false;
+	}
+
+	size_t stride = ((size_t)width * channels * depth + 7) / 8;
+	size_t rawLen = (stride + 1) * height;
+	uint8_t *raw = malloc(rawLen);
+	int pixelBytes = (channels * depth + 7) / 8;
+	long got = inflateZlib(idat, idatLen, raw, rawLen);
+	free(idat);
+	if (got != (long)rawLen || !unfilter(raw, height, stride, pixelBytes))
+	{
+		fprintf(stderr, "PNG image data is corrupt\n");
+		free(raw);
+		return false;
+	}
+
+	img->width = width;
+	img->height = height;
+	img->rgba = malloc((size_t)width * height * 4);
+	for (uint32_t y = 0; y < height; y++)
+	{
+		const uint8_t *row = raw + y * (stride + 1) + 1;
+		uint8_t *out = img->rgba + (size_t)y * width * 4;
+		for (uint32_t x = 0; x < width; x++, out += 4)
+		{
+			switch (type)
+			{
+			case PNG_PALETTE:
+				memcpy(out, palette[sample(row, x, depth, false)], 4);
+				break;
+			case PNG_GRAY:
+			case PNG_GRAY_ALPHA:
+				out[0] = out[1] = out[2] = sample(row, x * channels, depth, true);
+				out[3] = channels == 2 ? sample(row, x * 2 + 1, depth, true) : 255;
+				break;
+			default:
+				out[0] = sample(row, x * channels, depth, true);
+				out[1] = sample(row, x * channels + 1, depth, true);
+				out[2] = sample(row, x * channels + 2, depth, true);
+				out[3] = channels == 4 ? sample(row, x * 4 + 3, depth, true) : 255;
+				break;
+			}
+		}
+	}
+	free(raw);
+	return true;
+}
@@ -13,7 +13,12 @@
  *
  * RESOURCES USED
  *  - PIO state machines 0, 1, and 2 on PIO instance 0
- *  - DMA channels 0 and 1
+ *  - DMA channels 0, 1 and 2
+ *  - DMA_IRQ_0 (shared handler, raised at the end of every scanline)
+ *  - 640 Bytes of RAM for the cursor overlay lines
+ *  - 1 more DMA channel, the XIP stream and 960 Bytes of RAM for lines sourced from flash
+ *  - Core 1 and 1.3 kBytes of RAM while the overlay plane compositor runs
+ *  - 640 Bytes of RAM for lines with temporal dithering
  *  - 153.6 kBytes of RAM (for pixel color data)
  *
  *
@@ -22,8 +27,13 @@
  */
 
 #include "pico/stdlib.h"
+#include <string.h>
 #include "hardware/pio.h"
 #include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/regs/addressmap.h"
+#include "hardware/structs/xip_ctrl.h"
+#include "pico/multicore.h"
 
 #include "vga.h"
 
@@ -45,14 +55,370 @@ uint16_t _width = 320;
 uint16_t _height = 240;
 
 // Pixel color array that is DMA's to the PIO machines and
-// a pointer to the ADDRESS of this color array.
+// the table holding the ADDRESS of every scanline within it.
 // Note that this array is automatically initialized to all 0's (black)
-unsigned char vga_data_array[TXCOUNT];
-char *address_pointer = &vga_data_array[0];
+unsigned char vga_data_array[TXCOUNT] __attribute__((aligned(4)));
+
+// Address of every scanline, as set by the application. Pointing an entry
+// elsewhere changes what that line shows without touching the pixels.
+const unsigned char *vga_line_table[LINE_COUNT];
+
+// Control block channel one writes into channel zero's alias 1 registers (ctrl, read
+// address, write address and count, which triggers it) to send a line
+typedef struct
+{
+    uint32_t ctrl;
+    const unsigned char *read;
+    volatile void *write;
+    uint32_t count;
+} VGAscanBlock;
+
+// Table channel one walks, one block per line. The line handler fills every
+// entry two lines ahead of the beam from vga_line_table, substituting
+// composited copies where an overlay covers the line. The last block chains
+// channel zero to channel two, which points channel one back at the first
+// block, so the scan-out stays in the table without the interrupt.
+static VGAscanBlock vga_scan_table[LINE_COUNT] __attribute__((aligned(16)));
+static const VGAscanBlock *vga_scan_start = vga_scan_table;
+
+// DMA channels sending the pixel data
+int rgb_chan_0;
+int rgb_chan_1;
+int rgb_chan_2;
 
 // DMA channel for dma_memcpy and dma_memset
 int memcpy_dma_chan;
 
+// Last line channel zero finished sending, and frames sent since start
+volatile uint16_t vga_scanline = LINE_COUNT - 1;
+// Last line whose raster callbacks have run, its source is final from then on
+static volatile uint16_t vga_raster_line = 2;
+volatile uint32_t vga_frame_count = 0;
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ================================== Cursor overlay ================================================
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Default arrow, one 16-bit word per row with the leftmost pixel in the top bit
+static const uint16_t arrow_fill[VGA_CURSOR_SIZE] = {
+    0x0000, 0x0000, 0x4000, 0x6000, 0x7000, 0x7800, 0x7c00, 0x7e00,
+    0x7f00, 0x7f80, 0x7c00, 0x6c00, 0x4600, 0x0600, 0x0300, 0x0000};
+static const uint16_t arrow_outline[VGA_CURSOR_SIZE] = {
+    0x8000, 0xc000, 0xa000, 0x9000, 0x8800, 0x8400, 0x8200, 0x8100,
+    0x8080, 0x8040, 0x83e0, 0x9200, 0xa900, 0xc900, 0x8480, 0x0300};
+
+static const uint16_t *volatile cursor_fill = arrow_fill;
+static const uint16_t *volatile cursor_outline = arrow_outline;
+static volatile uint8_t cursor_height = VGA_CURSOR_SIZE;
+static uint8_t cursor_fill_pixel = VGA_PIXEL(WHITE);
+static uint8_t cursor_outline_pixel = VGA_PIXEL(BLACK);
+
+// Position as last requested, and as latched for the frame being sent
+static volatile int16_t cursor_req_x = 0;
+static volatile int16_t cursor_req_y = 0;
+static volatile bool cursor_req_visible = false;
+static int16_t cursor_x = 0;
+static int16_t cursor_y = 0;
+static bool cursor_visible = false;
+
+// Composited lines, alternating so one is filled while the other is sent
+static unsigned char cursor_lines[2][LINE_PIXELS] __attribute__((aligned(4)));
+
+static const unsigned char *__not_in_flash_func(VGA_composeCursor)(uint16_t line, const unsigned char *src)
+{
+    unsigned char *dst = cursor_lines[line & 1];
+    uint16_t fill = cursor_fill[line - cursor_y];
+    uint16_t outline = cursor_outline[line - cursor_y];
+
+    memcpy(dst, src, LINE_PIXELS);
+    for (int16_t i = 0, x = cursor_x; i < VGA_CURSOR_SIZE; i++, x++)
+    {
+        uint16_t bit = 0x8000 >> i;
+        if (x < 0 || x >= LINE_PIXELS || !((fill | outline) & bit))
+            continue;
+        dst[x] = (outline & bit) ? cursor_outline_pixel : cursor_fill_pixel;
+    }
+    return dst;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ================================== Overlay plane =================================================
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// 4 bit per pixel plane merged over the lines on core 1. Two pixels per byte, the left one
+// in the low nibble, nibbles with bit 3 set (VGA_TRANSPARENT) let the line below show through.
+static uint8_t *overlay_buf = NULL;
+static uint16_t overlay_top = 0;
+static uint16_t overlay_rows = 0;
+static volatile bool overlay_active = false;
+static bool compositor_running = false;
+
+// For each overlay byte: the two output pixels in the low half and the
+// mask of background pixels to keep in the high half
+static uint32_t overlay_lut[256];
+
+// Merged lines, the compositor stays one line ahead of the line handler
+#define OVERLAY_LINES 4
+static unsigned char overlay_lines[OVERLAY_LINES][LINE_PIXELS] __attribute__((aligned(4)));
+
+static void __not_in_flash_func(VGA_composeOverlay)(uint16_t line)
+{
+    const unsigned char *src = vga_line_table[line];
+    const uint8_t *ov = &overlay_buf[(line - overlay_top) * (LINE_PIXELS / 2)];
+    unsigned char *dst = overlay_lines[line % OVERLAY_LINES];
+
+    if ((uintptr_t)src & 3)
+    {
+        // Unaligned source, merge a byte at a time
+        for (uint16_t i = 0; i < LINE_PIXELS / 2; i++)
+        {
+            uint32_t e = overlay_lut[ov[i]];
+            dst[2 * i] = (src[2 * i] & (e >> 16)) | e;
+            dst[2 * i + 1] = (src[2 * i + 1] & (e >> 24)) | (e >> 8);
+        }
+        return;
+    }
+
+    // Four pixels per word, skipping the LUT where the overlay is clear
+    const uint32_t *bg = (const uint32_t *)src;
+    const uint16_t *ov16 = (const uint16_t *)ov;
+    uint32_t *out = (uint32_t *)dst;
+    for (uint16_t i = 0; i < LINE_PIXELS / 4; i++)
+    {
+        uint16_t o = ov16[i];
+        if (o == 0x8888)
+        {
+            out[i] = bg[i];
+            continue;
+        }
+        uint32_t e0 = overlay_lut[o & 0xff];
+        uint32_t e1 = overlay_lut[o >> 8];
+        uint32_t mask = (e0 >> 16) | (e1 & 0xffff0000);
+        uint32_t val = (e0 & 0xffff) | (e1 << 16);
+        out[i] = (bg[i] & mask) | val;
+    }
+}
+
+// Core 1 main loop, composes each overlay line once its raster callbacks have run, a line
+// before the handler queues it
+static void __not_in_flash_func(VGA_compositorLoop)(void)
+{
+    uint16_t done = vga_raster_line;
+    while (1)
+    {
+        uint16_t target = vga_raster_line;
+        if (target == done)
+            continue;
+        done = target;
+        if (overlay_active && target >= overlay_top && target < overlay_top + overlay_rows)
+            VGA_composeOverlay(target);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// =================================== Flash lines ==================================================
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Lines whose source is in flash are streamed into RAM a line before they are queued, so a
+// whole line time passes between starting a stream and publishing its buffer. The XIP stream
+// reads flash in bursts that bypass the cache, so static artwork neither evicts code from the
+// cache nor makes the pixel DMA wait on cache misses.
+#define FLASH_LINES 3
+static unsigned char flash_lines[FLASH_LINES][LINE_PIXELS] __attribute__((aligned(4)));
+static int flash_chan;
+static const unsigned char *stream_src = NULL; // Source of the line being streamed, NULL for none
+static uint16_t stream_line;
+
+static inline bool isFlash(const unsigned char *src)
+{
+    return (uintptr_t)src >= XIP_BASE && (uintptr_t)src < XIP_CTRL_BASE;
+}
+
+static void __not_in_flash_func(VGA_streamLine)(uint16_t line, const unsigned char *src)
+{
+    // Unaligned lines can't be streamed, and a stream still running means flash is
+    // too slow; the line is then read through the cache when it is queued
+    if (!isFlash(src) || ((uintptr_t)src & 3) || dma_channel_is_busy(flash_chan))
+    {
+        stream_src = NULL;
+        return;
+    }
+
+    while (!(xip_ctrl_hw->stat & XIP_STAT_FIFO_EMPTY))
+        (void)xip_ctrl_hw->stream_fifo;
+    xip_ctrl_hw->stream_addr = ((uintptr_t)src & 0x00ffffff) | XIP_BASE;
+    xip_ctrl_hw->stream_ctr = LINE_PIXELS / 4;
+    dma_channel_set_write_addr(flash_chan, flash_lines[line % FLASH_LINES], false);
+    dma_channel_set_trans_count(flash_chan, LINE_PIXELS / 4, true);
+    stream_src = src;
+    stream_line = line;
+}
+
+// The streamed copy of a line if it has fully arrived, otherwise the line itself from flash.
+// A stream for an older source is ignored, as a raster callback may have moved the line since.
+static inline const unsigned char *streamedLine(uint16_t line, const unsigned char *src)
+{
+    if (src != stream_src || line != stream_line || dma_channel_is_busy(flash_chan))
+        return src;
+    return flash_lines[line % FLASH_LINES];
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ================================ Temporal dithering ==============================================
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// On lines in the temporal band a pixel byte holds two colours, one in bits 0-2 and one in
+// bits 3-5 (VGA_MIXED), shown on alternate frames. Plain pixels hold the same colour twice so
+// they don't change. Neighbouring pixels and lines take opposite turns, which makes a mix
+// shimmer as a fine checkerboard rather than flicker as a whole area.
+static volatile uint16_t temporal_req_top = 0;
+static volatile uint16_t temporal_req_rows = 0;
+static uint16_t temporal_top = 0;
+static uint16_t temporal_rows = 0;
+static bool temporal_phase = false;
+
+// Split lines, alternating so one is filled while the other is sent
+static unsigned char temporal_lines[2][LINE_PIXELS] __attribute__((aligned(4)));
+
+static const unsigned char *__not_in_flash_func(VGA_splitLine)(uint16_t line, const unsigned char *src)
+{
+    unsigned char *dst = temporal_lines[line & 1];
+    // Bytes showing the colour in bits 0-2 this frame, the others show bits 3-5
+    uint32_t first = (temporal_phase ^ (line & 1)) ? 0xff00ff00 : 0x00ff00ff;
+
+    if ((uintptr_t)src & 3)
+    {
+        for (uint16_t x = 0; x < LINE_PIXELS; x++)
+        {
+            uint8_t c = (first >> ((x & 3) * 8)) & 1 ? src[x] : src[x] >> 3;
+            dst[x] = VGA_PIXEL(c & 7);
+        }
+        return dst;
+    }
+
+    // Four pixels at a time: pick a field per byte, then copy it into the other (x * 9 == x | x << 3)
+    const uint32_t *in = (const uint32_t *)src;
+    uint32_t *out = (uint32_t *)dst;
+    for (uint16_t i = 0; i < LINE_PIXELS / 4; i++)
+    {
+        uint32_t w = in[i];
+        out[i] = (((w & first) | ((w >> 3) & ~first)) & 0x07070707) * 9;
+    }
+    return dst;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+// ================================= Raster callbacks ===============================================
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+    VGArasterFn fn;
+    void *data;
+    uint16_t line;
+    uint32_t last_entry;
+    VGArasterStats stats;
+} VGAraster;
+
+static VGAraster raster[VGA_MAX_RASTER_CALLBACKS];
+
+// One bit per line that has a callback, so the handler tests a single word
+static uint32_t raster_lines[(LINE_COUNT + 31) / 32];
+
+static void __not_in_flash_func(VGA_runRaster)(uint16_t line)
+{
+    for (uint8_t i = 0; i < VGA_MAX_RASTER_CALLBACKS; i++)
+    {
+        VGAraster *r = &raster[i];
+        if (!r->fn || r->line != line)
+            continue;
+
+        uint32_t start = time_us_32();
+        r->fn(line, r->data);
+        uint32_t took = time_us_32() - start;
+
+        // Jitter shows up as spread between the shortest and longest period
+        VGArasterStats *st = &r->stats;
+        if (st->calls)
+        {
+            uint32_t period = start - r->last_entry;
+            if (period < st->min_period_us)
+                st->min_period_us = period;
+            if (period > st->max_period_us)
+                st->max_period_us = period;
+        }
+        r->last_entry = start;
+        st->calls++;
+        st->last_us = took;
+        if (took > st->max_us)
+            st->max_us = took;
+    }
+}
+
+// What channel zero should send for a line
+static inline const unsigned char *resolveLine(uint16_t line)
+{
+    const unsigned char *src = vga_line_table[line];
+    bool cursor = cursor_visible && line >= cursor_y && line < cursor_y + cursor_height;
+    bool temporal = line >= temporal_top && line < temporal_top + temporal_rows;
+    if (overlay_active && line >= overlay_top && line < overlay_top + overlay_rows)
+        src = overlay_lines[line % OVERLAY_LINES];
+    else if (!cursor && !temporal && isFlash(src))
+        src = streamedLine(line, src);
+    // Lines read from flash hold plain pixels and are left whole
+    if (temporal && !isFlash(src))
+        src = VGA_splitLine(line, src);
+    if (cursor)
+        src = VGA_composeCursor(line, src);
+    return src;
+}
+
+// Runs each time channel zero has sent a line to the PIO FIFO
+static void __not_in_flash_func(VGA_lineHandler)(void)
+{
+    if (!(dma_hw->ints0 & (1u << rgb_chan_0)))
+        return;
+    dma_hw->ints0 = 1u << rgb_chan_0;
+
+    uint16_t line = vga_scanline + 1;
+    if (line == LINE_COUNT)
+        line = 0;
+    vga_scanline = line;
+
+    if (line == LINE_COUNT - 1)
+        vga_frame_count++;
+
+    // The next line is already being sent, prepare the one after it
+    uint16_t ahead = line + 2;
+    if (ahead >= LINE_COUNT)
+        ahead -= LINE_COUNT;
+    if (ahead == 0)
+    {
+        // Latch the overlay state so a frame never shows it half moved
+        cursor_x = cursor_req_x;
+        cursor_y = cursor_req_y;
+        cursor_visible = cursor_req_visible;
+        temporal_top = temporal_req_top;
+        temporal_rows = temporal_req_rows;
+        temporal_phase = !temporal_phase;
+    }
+    // Callbacks run a line before their line is queued, ahead of everything that reads its
+    // source: the compositor, the flash stream and the queuing itself. So line source
+    // changes they make show from that line on.
+    uint16_t next = ahead + 1;
+    if (next == LINE_COUNT)
+        next = 0;
+    if (raster_lines[next >> 5] & (1u << (next & 31)))
+        VGA_runRaster(next);
+    vga_raster_line = next;
+
+    vga_scan_table[ahead].read = resolveLine(ahead);
+
+    // Start streaming the line after it. Its buffer was last sent three lines ago, and it is
+    // only published if the stream has finished by the time the line is queued.
+    VGA_streamLine(next, vga_line_table[next]);
+}
+
 void VGA_initDisplay(uint vsync_pin, uint hsync_pin, uint r_pin, uint pclk_pin)
 {
     // Choose which PIO instance to use (there are two instances, each with 4 state machines)
@@ -95,13 +461,24 @@ void VGA_initDisplay(uint vsync_pin, uint hsync_pin, uint r_pin, uint pclk_pin)
     // ===========================-== DMA Data Channels =================================================
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-    // DMA channels - 0 sends color data, 1 reconfigures and restarts 0
-    int rgb_chan_0 = dma_claim_unused_channel(true);
-    int rgb_chan_1 = dma_claim_unused_channel(true);
+    // DMA channels - 0 sends color data one line at a time, 1 reconfigures and restarts 0,
+    // 2 rewinds 1 at the end of the frame
+    rgb_chan_0 = dma_claim_unused_channel(true);
+    rgb_chan_1 = dma_claim_unused_channel(true);
+    rgb_chan_2 = dma_claim_unused_channel(true);
 
     // DMA channel for dma_memcpy and dma_memset
     memcpy_dma_chan = dma_claim_unused_channel(true);
 
+    // Flash line channel, drains the XIP stream FIFO into a line buffer
+    flash_chan = dma_claim_unused_channel(true);
+    dma_channel_config cf = dma_channel_get_default_config(flash_chan);
+    channel_config_set_transfer_data_size(&cf, DMA_SIZE_32);
+    channel_config_set_read_increment(&cf, false);
+    channel_config_set_write_increment(&cf, true);
+    channel_config_set_dreq(&cf, DREQ_XIP_STREAM);
+    dma_channel_configure(flash_chan, &cf, flash_lines[0], (const void *)XIP_AUX_BASE, LINE_PIXELS / 4, false);
+
     // Channel Zero (sends color data to PIO VGA machine)
     dma_channel_config c0 = dma_channel_get_default_config(rgb_chan_0); // default configs
     channel_config_set_transfer_data_size(&c0, DMA_SIZE_8);             // 8-bit txfers
@@ -113,31 +490,64 @@ void VGA_initDisplay(uint vsync_pin, uint hsync_pin, uint r_pin, uint pclk_pin)
         channel_config_set_dreq(&c0, DREQ_PIO1_TX2); // DREQ_PIO1_TX2 pacing (FIFO)
     channel_config_set_chain_to(&c0, rgb_chan_1);    // chain to other channel
 
+    // Every line chains to channel one for the next block, the last one to channel two
+    for (uint i = 0; i < LINE_COUNT; i++)
+    {
+        vga_line_table[i] = &vga_data_array[i * LINE_PIXELS];
+        vga_scan_table[i].read = vga_line_table[i];
+        vga_scan_table[i].write = &pio->txf[rgb_sm];
+        vga_scan_table[i].count = LINE_PIXELS;
+        vga_scan_table[i].ctrl = channel_config_get_ctrl_value(&c0);
+    }
+    dma_channel_config c0_last = c0;
+    channel_config_set_chain_to(&c0_last, rgb_chan_2);
+    vga_scan_table[LINE_COUNT - 1].ctrl = channel_config_get_ctrl_value(&c0_last);
+
     dma_channel_configure(
-        rgb_chan_0,        // Channel to be configured
-        &c0,               // The configuration we just created
-        &pio->txf[rgb_sm], // write address (RGB PIO TX FIFO)
-        &vga_data_array,   // The initial read address (pixel color array)
-        TXCOUNT,           // Number of transfers; in this case each is 1 byte.
-        false              // Don't start immediately.
+        rgb_chan_0,             // Channel to be configured
+        &c0,                    // The configuration we just created
+        &pio->txf[rgb_sm],      // write address (RGB PIO TX FIFO)
+        vga_scan_table[0].read, // The initial read address (first line of the pixel color array)
+        LINE_PIXELS,            // Number of transfers; in this case each is 1 byte.
+        false                   // Don't start immediately.
     );
 
     // Channel One (reconfigures the first channel)
     dma_channel_config c1 = dma_channel_get_default_config(rgb_chan_1); // default configs
     channel_config_set_transfer_data_size(&c1, DMA_SIZE_32);            // 32-bit txfers
-    channel_config_set_read_increment(&c1, false);                      // no read incrementing
-    channel_config_set_write_increment(&c1, false);                     // no write incrementing
-    channel_config_set_chain_to(&c1, rgb_chan_0);                       // chain to other channel
+    channel_config_set_read_increment(&c1, true);                       // yes read incrementing (walks the line table)
+    channel_config_set_write_increment(&c1, true);                      // yes write incrementing (the four alias 1 registers)
+    channel_config_set_ring(&c1, true, 4);                              // and back to the first of them for the next block
+
+    dma_channel_configure(
+        rgb_chan_1,                       // Channel to be configured
+        &c1,                              // The configuration we just created
+        &dma_hw->ch[rgb_chan_0].al1_ctrl, // Write address (channel 0 alias 1, the count restarts it)
+        &vga_scan_table[1],               // Read address (TABLE OF LINE BLOCKS)
+        4,                                // Number of transfers, one block of four words
+        false                             // Don't start immediately.
+    );
+
+    // Channel Two (rewinds channel one to the first block, which also restarts it)
+    dma_channel_config c2 = dma_channel_get_default_config(rgb_chan_2); // default configs
+    channel_config_set_transfer_data_size(&c2, DMA_SIZE_32);            // 32-bit txfers
+    channel_config_set_read_increment(&c2, false);                      // no read incrementing
+    channel_config_set_write_increment(&c2, false);                     // no write incrementing
 
     dma_channel_configure(
-        rgb_chan_1,                        // Channel to be configured
-        &c1,                               // The configuration we just created
-        &dma_hw->ch[rgb_chan_0].read_addr, // Write address (channel 0 read address)
-        &address_pointer,                  // Read address (POINTER TO AN ADDRESS)
-        1,                                 // Number of transfers, in this case each is 4 byte
-        false                              // Don't start immediately.
+        rgb_chan_2,                                 // Channel to be configured
+        &c2,                                        // The configuration we just created
+        &dma_hw->ch[rgb_chan_1].al3_read_addr_trig, // Write address (channel 1 read address, also restarts it)
+        &vga_scan_start,                            // Read address (POINTER TO THE FIRST BLOCK)
+        1,                                          // Number of transfers, in this case each is 4 byte
+        false                                       // Don't start immediately.
     );
 
+    // Count the lines as they are sent, so we know where the beam is
+    dma_channel_set_irq0_enabled(rgb_chan_0, true);
+    irq_add_shared_handler(DMA_IRQ_0, VGA_lineHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -207,11 +617,218 @@ void dma_memcpy(void *dest, void *src, size_t num)
 
 void VGA_fillScreen(uint16_t color)
 {
-    dma_memset(vga_data_array, (color) | (color << 3), TXCOUNT);
+    dma_memset(vga_data_array, VGA_PIXEL(color), TXCOUNT);
 }
 
 
 void VGA_drawFrame(void *src)
 {
     dma_memcpy(vga_data_array, src, TXCOUNT);
-}
\ No newline at end of file
+}
+
+void VGA_setLineSource(uint line, const void *src)
+{
+    if (line >= LINE_COUNT)
+        return;
+    vga_line_table[line] = src;
+}
+
+void VGA_setBandSource(uint y, uint h, const void *src)
+{
+    const unsigned char *line = src;
+    for (uint i = 0; i < h && y + i < LINE_COUNT; i++, line += LINE_PIXELS)
+        vga_line_table[y + i] = line;
+}
+
+const void *VGA_getLineSource(uint line)
+{
+    return line < LINE_COUNT ? vga_line_table[line] : NULL;
+}
+
+uint16_t VGA_getScanline(void)
+{
+    return vga_scanline;
+}
+
+uint32_t VGA_getFrameCount(void)
+{
+    return vga_frame_count;
+}
+
+void VGA_waitForVBlank(void)
+{
+    uint32_t frame = vga_frame_count;
+    while (vga_frame_count == frame)
+        tight_loop_contents();
+}
+
+void VGA_setCursorShape(const uint16_t *fill, const uint16_t *outline, uint8_t height)
+{
+    static const uint16_t empty[VGA_CURSOR_SIZE] = {0};
+
+    if (!fill && !outline)
+    {
+        fill = arrow_fill;
+        outline = arrow_outline;
+        height = VGA_CURSOR_SIZE;
+    }
+    if (height > VGA_CURSOR_SIZE)
+        height = VGA_CURSOR_SIZE;
+
+    // The line handler stops reading the shape while the height is zero
+    cursor_height = 0;
+    cursor_fill = fill ? fill : empty;
+    cursor_outline = outline ? outline : empty;
+    cursor_height = height;
+}
+
+void VGA_setCursorColors(uint16_t fill, uint16_t outline)
+{
+    cursor_fill_pixel = VGA_PIXEL(fill);
+    cursor_outline_pixel = VGA_PIXEL(outline);
+}
+
+void VGA_moveCursor(int16_t x, int16_t y)
+{
+    cursor_req_x = x;
+    cursor_req_y = y;
+}
+
+void VGA_showCursor(bool visible)
+{
+    cursor_req_visible = visible;
+}
+
+void VGA_setOverlay(uint8_t *buf, uint16_t y, uint16_t h)
+{
+    overlay_active = false;
+    if (!buf || y >= LINE_COUNT)
+    {
+        overlay_buf = NULL;
+        overlay_rows = 0;
+        return;
+    }
+    if (y + h > LINE_COUNT)
+        h = LINE_COUNT - y;
+
+    for (uint i = 0; i < 256; i++)
+    {
+        uint8_t lo = i & 0xf;
+        uint8_t hi = i >> 4;
+        uint32_t val = 0, mask = 0;
+        if (lo & VGA_TRANSPARENT)
+            mask |= 0x00ff;
+        else
+            val |= VGA_PIXEL(lo);
+        if (hi & VGA_TRANSPARENT)
+            mask |= 0xff00;
+        else
+            val |= VGA_PIXEL(hi) << 8;
+        overlay_lut[i] = val | (mask << 16);
+    }
+
+    overlay_buf = buf;
+    overlay_top = y;
+    overlay_rows = h;
+    VGA_clearOverlay();
+    overlay_active = compositor_running;
+}
+
+void VGA_clearOverlay(void)
+{
+    if (overlay_buf)
+        dma_memset(overlay_buf, VGA_TRANSPARENT | (VGA_TRANSPARENT << 4), overlay_rows * (LINE_PIXELS / 2));
+}
+
+uint8_t *VGA_getOverlayRow(int16_t y)
+{
+    if (!overlay_buf || y < overlay_top || y >= overlay_top + overlay_rows)
+        return NULL;
+    return &overlay_buf[(y - overlay_top) * (LINE_PIXELS / 2)];
+}
+
+void VGA_startCompositor(void)
+{
+    multicore_launch_core1(VGA_compositorLoop);
+    compositor_running = true;
+    overlay_active = overlay_buf != NULL;
+}
+
+void VGA_setTemporal(uint16_t y, uint16_t h)
+{
+    if (y >= LINE_COUNT)
+        h = 0;
+    else if (y + h > LINE_COUNT)
+        h = LINE_COUNT - y;
+
+    // Latched with the cursor at the start of the next frame, emptied first so a
+    // half-written band is never latched
+    temporal_req_rows = 0;
+    temporal_req_top = y;
+    temporal_req_rows = h;
+}
+
+static void updateRasterLines(void)
+{
+    uint32_t lines[count_of(raster_lines)] = {0};
+    for (uint8_t i = 0; i < VGA_MAX_RASTER_CALLBACKS; i++)
+        if (raster[i].fn)
+            lines[raster[i].line >> 5] |= 1u << (raster[i].line & 31);
+    for (uint i = 0; i < count_of(raster_lines); i++)
+        raster_lines[i] = lines[i];
+}
+
+int8_t VGA_addRasterCallback(uint16_t line, VGArasterFn fn, void *data)
+{
+    if (line >= LINE_COUNT || !fn)
+        return -1;
+    for (uint8_t i = 0; i < VGA_MAX_RASTER_CALLBACKS; i++)
+    {
+        VGAraster *r = &raster[i];
+        if (r->fn)
+            continue;
+        uint32_t irq = save_and_disable_interrupts();
+        r->line = line;
+        r->data = data;
+        r->fn = fn;
+        VGA_resetRasterStats(i);
+        updateRasterLines();
+        restore_interrupts(irq);
+        return i;
+    }
+    return -1;
+}
+
+void VGA_removeRasterCallback(int8_t id)
+{
+    if (id < 0 || id >= VGA_MAX_RASTER_CALLBACKS)
+        return;
+    uint32_t irq = save_and_disable_interrupts();
+    raster[id].fn = NULL;
+    updateRasterLines();
+    restore_interrupts(irq);
+}
+
+bool VGA_getRasterStats(int8_t id, VGArasterStats *stats)
+{
+    if (id < 0 || id >= VGA_MAX_RASTER_CALLBACKS || !raster[id].fn)
+        return false;
+    uint32_t irq = save_and_disable_interrupts();
+    *stats = raster[id].stats;
+    restore_interrupts(irq);
+    return true;
+}
+
+void VGA_resetRasterStats(int8_t id)
+{
+    if (id < 0 || id >= VGA_MAX_RASTER_CALLBACKS)
+        return;
+    uint32_t irq = save_and_disable_interrupts();
+    VGArasterStats *st = &raster[id].stats;
+    st->calls = 0;
+    st->last_us = 0;
+    st->max_us = 0;
+    st->min_period_us = UINT32_MAX;
+    st->max_period_us = 0;
+    restore_interrupts(irq);
+}
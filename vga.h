@@ -6,6 +6,23 @@
 
 // Length of the pixel array, and number of DMA transfers
 #define TXCOUNT 76800 // Total pixels
+#define LINE_PIXELS 320 // Pixels (and DMA transfers) per scanline
+#define LINE_COUNT 240  // Active scanlines
+
+#define VGA_CURSOR_SIZE 16 // Maximum width and height of the cursor overlay
+
+#define VGA_TRANSPARENT 8 // Overlay plane colour that shows the line below
+
+// Bytes of overlay plane storage for a number of lines
+#define VGA_OVERLAY_BYTES(lines) ((lines) * (LINE_PIXELS / 2))
+
+#define VGA_MAX_RASTER_CALLBACKS 8 // Scanline callbacks that can be registered at once
+
+// Byte stored in the pixel array for a colour
+#define VGA_PIXEL(color) ((color) | ((color) << 3))
+
+// Byte for a pixel alternating between colours a and b on lines set with VGA_setTemporal
+#define VGA_MIXED(a, b) ((a) | ((b) << 3))
 
 #if VGA_BGR
 #define BLACK 0b0
@@ -26,6 +43,19 @@
 #define CYAN 6
 #define WHITE 7
 #endif
+/// Called from the line interrupt just before `line` is queued for sending
+typedef void (*VGArasterFn)(uint16_t line, void *data);
+
+/// Timing of a scanline callback, in microseconds
+typedef struct
+{
+    uint32_t calls;         ///< Times the callback ran
+    uint32_t last_us;       ///< Duration of the last call
+    uint32_t max_us;        ///< Longest call
+    uint32_t min_period_us; ///< Shortest time between two calls
+    uint32_t max_period_us; ///< Longest time between two calls, the spread to min_period_us is the jitter
+} VGArasterStats;
+
 void VGA_writePixel(int x, int y, char color);
 void VGA_initDisplay(uint vsync_pin, uint hsync_pin, uint r_pin, uint pclk_pin);
 
@@ -33,6 +63,30 @@ void VGA_fillScreen(uint16_t color);
 
 void VGA_drawFrame(void *src);
 
+void VGA_setLineSource(uint line, const void *src);
+void VGA_setBandSource(uint y, uint h, const void *src);
+const void *VGA_getLineSource(uint line);
+uint16_t VGA_getScanline(void);
+uint32_t VGA_getFrameCount(void);
+void VGA_waitForVBlank(void);
+
+void VGA_setCursorShape(const uint16_t *fill, const uint16_t *outline, uint8_t height);
+void VGA_setCursorColors(uint16_t fill, uint16_t outline);
+void VGA_moveCursor(int16_t x, int16_t y);
+void VGA_showCursor(bool visible);
+
+void VGA_setOverlay(uint8_t *buf, uint16_t y, uint16_t h);
+void VGA_clearOverlay(void);
+uint8_t *VGA_getOverlayRow(int16_t y);
+void VGA_startCompositor(void);
+
+void VGA_setTemporal(uint16_t y, uint16_t h);
+
+int8_t VGA_addRasterCallback(uint16_t line, VGArasterFn fn, void *data);
+void VGA_removeRasterCallback(int8_t id);
+bool VGA_getRasterStats(int8_t id, VGArasterStats *stats);
+void VGA_resetRasterStats(int8_t id);
+
 void dma_memset(void *dest, uint8_t val, size_t num);
 void dma_memcpy(void *dest, void *src, size_t num);
 #endif
\ No newline at end of file